@@ -1,5 +1,7 @@
 #include "pch.h"
 #include "QuestCatalog.h"
+#include "QuestSnapshot.h"
+#include "../util/Parallel.h"
 
 namespace arena2 {
 
@@ -95,10 +97,13 @@ static bool LoadFromQuestRoot(QuestCatalog& catalog,
                               const std::filesystem::path& folder,
                               const std::vector<std::filesystem::path>& relCandidates,
                               const VarHashCatalog* varHashes,
+                              const std::filesystem::path& snapshotDir,
                               std::wstring* err,
                               const wchar_t* notFoundMessage) {
     catalog.quests.clear();
     catalog.hashes = varHashes;
+    catalog.hashesFingerprint = varHashes ? varHashes->Fingerprint() : 0;
+    catalog.fromSnapshot = false;
 
     std::filesystem::path root;
     if (!TryResolveQuestRoot(folder, relCandidates, root)) {
@@ -117,18 +122,25 @@ static bool LoadFromQuestRoot(QuestCatalog& catalog,
 
     std::sort(qbnFiles.begin(), qbnFiles.end(), [](const auto& a, const auto& b) { return UpperStem(a) < UpperStem(b); });
 
-    catalog.quests.reserve(qbnFiles.size());
-    for (const auto& qbn : qbnFiles) {
-        QuestEntry e{};
-        e.baseName = UpperStem(qbn);
-        e.qbnPath = qbn;
-        e.qrcPath = qbn;
+    catalog.quests.resize(qbnFiles.size());
+    for (size_t i = 0; i < qbnFiles.size(); ++i) {
+        QuestEntry& e = catalog.quests[i];
+        e.baseName = UpperStem(qbnFiles[i]);
+        e.qbnPath = qbnFiles[i];
+        e.qrcPath = qbnFiles[i];
         e.qrcPath.replace_extension(".QRC");
         ParseFilenameMeta(e);
+    }
 
-        std::wstring perr;
-        e.qbnLoaded = e.qbn.LoadFromFile(e.qbnPath, varHashes, &perr);
-        catalog.quests.push_back(std::move(e));
+    if (!snapshotDir.empty() && LoadQuestSnapshot(snapshotDir, catalog)) {
+        catalog.fromSnapshot = true;
+    } else {
+        // Each worker fills its own pre-sized slot, so the sorted order and qbnLoaded flags do not depend on scheduling.
+        winutil::ParallelFor(catalog.quests.size(), 0, [&](size_t i, size_t) {
+            QuestEntry& e = catalog.quests[i];
+            std::wstring perr;
+            e.qbnLoaded = e.qbn.LoadFromFile(e.qbnPath, varHashes, &perr);
+        });
     }
 
     if (catalog.quests.empty()) {
@@ -136,6 +148,7 @@ static bool LoadFromQuestRoot(QuestCatalog& catalog,
         return false;
     }
 
+    catalog.xref.Build(catalog.quests);
     return true;
 }
 
@@ -208,21 +221,21 @@ static std::string FirstSentenceOrLine(const std::string& s) {
     return line;
 }
 
-static void DeriveQuestDisplayName(QuestEntry& q) {
-    q.displayName.clear();
-    q.displayNameSourceRecord = 0;
+void DeriveQuestDisplayName(const QuestQbn& qbn, TextRsc& qrc, std::string& displayName, uint16_t& sourceRecord) {
+    displayName.clear();
+    sourceRecord = 0;
 
-    if (!q.qrcLoaded) return;
-    if (q.qrc.records.empty()) return;
+    if (qrc.records.empty()) return;
 
     auto pickFromRecord = [&](uint16_t recId) -> bool {
-        auto* rec = q.qrc.FindMutable(recId);
+        auto* rec = qrc.FindMutable(recId);
         if (!rec) return false;
-        rec->EnsureParsed(q.qrc.fileBytes);
+        rec->EnsureParsed(qrc.fileBytes);
         if (rec->subrecords.empty()) return false;
 
-        auto& tt = rec->subrecords[0].EnsureTokens();
-        std::string t = SanitizeForTitle(tt.plain);
+        std::string t;
+        RenderPlain(rec->subrecords[0].EnsureTokens(), t);
+        t = SanitizeForTitle(std::move(t));
         t = FirstSentenceOrLine(t);
         if (t.size() < 6) return false;
 
@@ -235,14 +248,14 @@ static void DeriveQuestDisplayName(QuestEntry& q) {
             t += "...";
         }
 
-        q.displayName = t;
-        q.displayNameSourceRecord = recId;
+        displayName = t;
+        sourceRecord = recId;
         return true;
     };
 
     // Preferred: derive from the first "Create Log Entry" pseudo-code (opCode 0x0017),
     // which references the log text via Sub-record 2 (a message ID).
-    for (const auto& op : q.qbn.opcodes) {
+    for (const auto& op : qbn.opcodes) {
         if (op.opCode != 0x0017) continue;
         if ((int)op.records < 3) continue;
 
@@ -262,16 +275,17 @@ static void DeriveQuestDisplayName(QuestEntry& q) {
     }
 
     // Final fallback: first record's first subrecord.
-    auto& r0 = q.qrc.records[0];
-    r0.EnsureParsed(q.qrc.fileBytes);
+    auto& r0 = qrc.records[0];
+    r0.EnsureParsed(qrc.fileBytes);
     if (!r0.subrecords.empty()) {
-        auto& tt = r0.subrecords[0].EnsureTokens();
-        std::string t = SanitizeForTitle(tt.plain);
+        std::string t;
+        RenderPlain(r0.subrecords[0].EnsureTokens(), t);
+        t = SanitizeForTitle(std::move(t));
         t = FirstSentenceOrLine(t);
         if (t.size() > 88) { t = t.substr(0, 85); t += "..."; }
         if (!t.empty()) {
-            q.displayName = t;
-            q.displayNameSourceRecord = r0.recordId;
+            displayName = t;
+            sourceRecord = r0.recordId;
         }
     }
 }
@@ -302,24 +316,56 @@ static void ParseFilenameMeta(QuestEntry& q) {
 
 }
 
-bool QuestCatalog::LoadFromArena2Root(const std::filesystem::path& folder, const VarHashCatalog* varHashes, std::wstring* err) {
+bool QuestCatalog::LoadFromArena2Root(const std::filesystem::path& folder, const VarHashCatalog* varHashes, std::wstring* err,
+                                      const std::filesystem::path& snapshotDir) {
     return LoadFromQuestRoot(*this,
                              folder,
                              { std::filesystem::path("."), std::filesystem::path("ARENA2") },
                              varHashes,
+                             snapshotDir,
                              err,
                              L"Could not find quest data folder (expected selected folder or an ARENA2 subfolder).");
 }
 
-bool QuestCatalog::LoadFromBattlespireRoot(const std::filesystem::path& folder, const VarHashCatalog* varHashes, std::wstring* err) {
+bool QuestCatalog::LoadFromBattlespireRoot(const std::filesystem::path& folder, const VarHashCatalog* varHashes, std::wstring* err,
+                                           const std::filesystem::path& snapshotDir) {
     return LoadFromQuestRoot(*this,
                              folder,
                              { std::filesystem::path("."), std::filesystem::path("GameData") },
                              varHashes,
+                             snapshotDir,
                              err,
                              L"Could not find Battlespire quest data folder (expected selected folder or a GameData subfolder).");
 }
 
+void QuestCatalogXref::Build(const std::vector<QuestEntry>& quests) {
+    refs.clear();
+    size_t total = 0;
+    for (const auto& q : quests) if (q.qbnLoaded) total += q.qbn.xref.refs.size();
+    refs.reserve(total);
+    for (size_t i = 0; i < quests.size(); ++i) {
+        if (!quests[i].qbnLoaded) continue;
+        for (const auto& r : quests[i].qbn.xref.refs) refs.push_back({ r.key, static_cast<uint32_t>(i), r.opcode, r.slot });
+    }
+    // Quest order is already ascending and each quest's refs are sorted, so a stable sort on the key is enough.
+    std::stable_sort(refs.begin(), refs.end(), [](const QuestCatalogRef& a, const QuestCatalogRef& b) { return a.key < b.key; });
+}
+
+std::span<const QuestCatalogRef> QuestCatalogXref::Find(QbnRefKind kind, uint16_t target) const {
+    const uint32_t key = QbnXref::Key(kind, target);
+    auto lo = std::lower_bound(refs.begin(), refs.end(), key, [](const QuestCatalogRef& r, uint32_t k) { return r.key < k; });
+    auto hi = std::upper_bound(lo, refs.end(), key, [](uint32_t k, const QuestCatalogRef& r) { return k < r.key; });
+    return { refs.data() + (lo - refs.begin()), static_cast<size_t>(hi - lo) };
+}
+
+std::vector<uint32_t> QuestCatalogXref::QuestsReferencing(QbnRefKind kind, uint16_t target) const {
+    std::vector<uint32_t> out;
+    for (const auto& r : Find(kind, target)) {
+        if (out.empty() || out.back() != r.quest) out.push_back(r.quest);
+    }
+    return out;
+}
+
 bool QuestCatalog::EnsureQrcLoaded(size_t questIndex, std::wstring* err) {
     if (questIndex >= quests.size()) return false;
     auto& q = quests[questIndex];
@@ -334,7 +380,19 @@ bool QuestCatalog::EnsureQrcLoaded(size_t questIndex, std::wstring* err) {
     if (!TextRsc::LoadFromFile(q.qrcPath, t, err)) return false;
     q.qrc = std::move(t);
     q.qrcLoaded = true;
-    DeriveQuestDisplayName(q);
+    DeriveQuestDisplayName(q.qbn, q.qrc, q.displayName, q.displayNameSourceRecord);
+    return true;
+}
+
+bool QuestCatalog::AdoptQrc(size_t questIndex, TextRsc&& qrc, std::string displayName, uint16_t displayNameSourceRecord) {
+    if (questIndex >= quests.size()) return false;
+    auto& q = quests[questIndex];
+    if (q.qrcLoaded) return false;
+
+    q.qrc = std::move(qrc);
+    q.qrcLoaded = true;
+    q.displayName = std::move(displayName);
+    q.displayNameSourceRecord = displayNameSourceRecord;
     return true;
 }
 
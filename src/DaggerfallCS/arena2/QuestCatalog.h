@@ -36,6 +36,23 @@ struct QuestEntry {
     bool qrcLoaded{ false };
 };
 
+struct QuestCatalogRef {
+    uint32_t key{};      // QbnXref::Key(kind, target)
+    uint32_t quest{};    // index into QuestCatalog::quests
+    uint16_t opcode{};
+    uint8_t slot{};
+};
+
+// Every loaded quest's QbnXref merged into one table, for reverse lookups across the whole catalog.
+struct QuestCatalogXref {
+    std::vector<QuestCatalogRef> refs;   // sorted by key, then quest, opcode and slot
+
+    void Build(const std::vector<QuestEntry>& quests);
+    std::span<const QuestCatalogRef> Find(QbnRefKind kind, uint16_t target) const;
+    // Distinct quest indices with at least one reference, ascending.
+    std::vector<uint32_t> QuestsReferencing(QbnRefKind kind, uint16_t target) const;
+};
+
 struct QuestCatalog {
     static const char* GuildNameForCode(char c);
     static const char* MembershipNameForCode(char c);
@@ -44,9 +61,15 @@ struct QuestCatalog {
     std::filesystem::path arena2Root;
     std::vector<QuestEntry> quests;
 	const VarHashCatalog* hashes{ nullptr };
+    uint64_t hashesFingerprint{};   // VarHashCatalog::Fingerprint of hashes at load time (0 without a catalog)
+    bool fromSnapshot{ false };
+    QuestCatalogXref xref;   // rebuilt by each load
 
-    bool LoadFromArena2Root(const std::filesystem::path& folder, const VarHashCatalog* varHashes, std::wstring* err);
-    bool LoadFromBattlespireRoot(const std::filesystem::path& folder, const VarHashCatalog* varHashes, std::wstring* err);
+    // With a snapshotDir, a valid snapshot of the quest folder (see QuestSnapshot.h) replaces parsing the QBNs.
+    bool LoadFromArena2Root(const std::filesystem::path& folder, const VarHashCatalog* varHashes, std::wstring* err,
+                            const std::filesystem::path& snapshotDir = {});
+    bool LoadFromBattlespireRoot(const std::filesystem::path& folder, const VarHashCatalog* varHashes, std::wstring* err,
+                                 const std::filesystem::path& snapshotDir = {});
     // Compatibility overloads: callers that don't have a hash catalog handy.
     bool LoadFromArena2Root(const std::filesystem::path& folder, std::wstring* err) {
         return LoadFromArena2Root(folder, nullptr, err);
@@ -61,6 +84,12 @@ struct QuestCatalog {
         return LoadFromBattlespireRoot(folder, nullptr, nullptr);
     }
     bool EnsureQrcLoaded(size_t questIndex, std::wstring* err);
+    // Installs a QRC loaded elsewhere (e.g. by a background preload) unless the quest already has one.
+    bool AdoptQrc(size_t questIndex, TextRsc&& qrc, std::string displayName, uint16_t displayNameSourceRecord);
 };
 
+// Picks a quest title from its QRC: the first "Create Log Entry" message, then the usual log/offer records, then
+// the first record. Only parses the given qrc, so it can run on a worker thread.
+void DeriveQuestDisplayName(const QuestQbn& qbn, TextRsc& qrc, std::string& displayName, uint16_t& sourceRecord);
+
 } // namespace arena2
@@ -174,8 +174,8 @@ static std::string MessagePreview(TextRsc* qrc, uint16_t msgId) {
     rec->EnsureParsed(qrc->fileBytes);
     if (rec->subrecords.empty()) return std::string();
 
-    auto& tt = rec->subrecords[0].EnsureTokens();
-    std::string p = tt.plain;
+    std::string p;
+    RenderPlain(rec->subrecords[0].EnsureTokens(), p);
     // keep short
     if (p.size() > 90) p = p.substr(0, 90) + "...";
     return p;
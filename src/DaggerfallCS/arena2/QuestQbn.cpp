@@ -59,6 +59,54 @@ static bool TrySectionBounds(const QbnHeader& h,
     return outCount > 0;
 }
 
+static bool RefKindForSection(const QbnSubRecord& sr, QbnRefKind& kind) {
+    switch (sr.sectionId) {
+    case 0:
+        if (sr.localPtr == 0x12345678) return false;   // constant operand
+        kind = QbnRefKind::Item;
+        return true;
+    case 3: kind = QbnRefKind::Npc; return true;
+    case 4: kind = QbnRefKind::Location; return true;
+    case 6: kind = QbnRefKind::Timer; return true;
+    case 7: kind = QbnRefKind::Mob; return true;
+    case 9: kind = QbnRefKind::State; return true;
+    default: return false;
+    }
+}
+
+void QbnXref::Build(const std::vector<QbnOpCodeRecord>& opcodes) {
+    refs.clear();
+    refs.reserve(opcodes.size() * 3);
+    for (size_t o = 0; o < opcodes.size() && o <= 0xFFFF; ++o) {
+        const auto& op = opcodes[o];
+        const uint16_t oi = static_cast<uint16_t>(o);
+        for (uint8_t i = 0; i < 5; ++i) {
+            QbnRefKind kind{};
+            if (!RefKindForSection(op.sub[i], kind)) continue;
+            const int rec = op.sub[i].LinkedIndex();
+            if (rec >= 0) refs.push_back({ Key(kind, static_cast<uint16_t>(rec)), oi, i });
+        }
+        if (op.messageId != 0x0000u && op.messageId != 0xFFFFu) refs.push_back({ Key(QbnRefKind::Message, op.messageId), oi, kMessageSlot });
+        // "Create Log Entry" can also carry its message as a constant second operand.
+        const auto& msg = op.sub[1];
+        if (op.opCode == 0x0017 && msg.sectionId == 0 && msg.localPtr == 0x12345678 && msg.value < 0xFFFFu) {
+            refs.push_back({ Key(QbnRefKind::Message, static_cast<uint16_t>(msg.value)), oi, 1 });
+        }
+    }
+    std::sort(refs.begin(), refs.end(), [](const QbnRef& a, const QbnRef& b) {
+        if (a.key != b.key) return a.key < b.key;
+        if (a.opcode != b.opcode) return a.opcode < b.opcode;
+        return a.slot < b.slot;
+    });
+}
+
+std::span<const QbnRef> QbnXref::Find(QbnRefKind kind, uint16_t target) const {
+    const uint32_t key = Key(kind, target);
+    auto lo = std::lower_bound(refs.begin(), refs.end(), key, [](const QbnRef& r, uint32_t k) { return r.key < k; });
+    auto hi = std::upper_bound(lo, refs.end(), key, [](uint32_t k, const QbnRef& r) { return k < r.key; });
+    return { refs.data() + (lo - refs.begin()), static_cast<size_t>(hi - lo) };
+}
+
 bool QuestQbn::LoadFromFile(const std::filesystem::path& path, const VarHashCatalog* hashes, std::wstring* err) {
     sourcePath = path;
     states.clear();
@@ -1,6 +1,7 @@
 #pragma once
 #include "../pch.h"
 #include "VarHashCatalog.h"
+#include <span>
 
 namespace arena2 {
 
@@ -31,6 +32,13 @@ struct QbnSubRecord {
         if (lo == 0xFFu) return -1;
         return (int)lo;
     }
+
+    // Record the sub-record links to, as the quest views resolve it: low byte of LocalPtr, else low word of Value.
+    int LinkedIndex() const {
+        int rec = (int)(localPtr & 0xFFu);
+        if (rec == 0xFF && value != 0xFFFFFFFFu && value != 0xFFFFFFFEu) rec = (int)(value & 0xFFFFu);
+        return rec == 0xFF ? -1 : rec;
+    }
 };
 
 struct QbnOpCodeRecord {
@@ -43,6 +51,28 @@ struct QbnOpCodeRecord {
     uint32_t fileOffset{}; // byte offset in QBN for debugging
 };
 
+// What an op-code reference points at. Sub-records map by section id (0 items, 3 NPCs, 4 locations, 6 timers,
+// 7 mobs, 9 states); messages come from the op-code's messageId and a log entry's constant message operand.
+enum class QbnRefKind : uint8_t { State, Item, Npc, Location, Timer, Mob, Message };
+
+struct QbnRef {
+    uint32_t key{};      // QbnXref::Key(kind, target)
+    uint16_t opcode{};   // index into QuestQbn::opcodes
+    uint8_t slot{};      // sub-record 0..4, or QbnXref::kMessageSlot
+};
+
+// Reverse index of one QBN's op-codes, so "what references X" costs the number of hits rather than a scan.
+struct QbnXref {
+    static constexpr uint8_t kMessageSlot = 5;
+
+    std::vector<QbnRef> refs;   // sorted by key, then opcode, then slot
+
+    static uint32_t Key(QbnRefKind kind, uint16_t target) { return (uint32_t(kind) << 16) | target; }
+
+    void Build(const std::vector<QbnOpCodeRecord>& opcodes);
+    std::span<const QbnRef> Find(QbnRefKind kind, uint16_t target) const;
+};
+
 struct QbnState {
     int16_t flagIndex{};
     uint8_t isGlobal{};
@@ -155,6 +185,8 @@ struct QuestQbn {
     std::unordered_map<uint16_t, size_t> timerByIndex;
     std::unordered_map<uint16_t, size_t> mobByIndex;
 
+    QbnXref xref;
+
     const QbnItem* FindItem(uint16_t idx) const {
         auto it = itemByIndex.find(idx);
         return (it == itemByIndex.end()) ? nullptr : &items[it->second];
@@ -183,6 +215,7 @@ struct QuestQbn {
         for (size_t i = 0; i < locations.size(); ++i) locationByIndex[locations[i].locationIndex] = i;
         for (size_t i = 0; i < timers.size(); ++i) timerByIndex[(uint16_t)timers[i].timerIndex] = i;
         for (size_t i = 0; i < mobs.size(); ++i) mobByIndex[(uint16_t)mobs[i].mobIndex] = i;
+        xref.Build(opcodes);
     }
     // Primary loader (source of truth). Optional catalogs and error output.
     bool LoadFromFile(const std::filesystem::path& path, const VarHashCatalog* hashes, std::wstring* err);
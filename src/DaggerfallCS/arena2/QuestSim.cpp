@@ -0,0 +1,283 @@
+#include "pch.h"
+#include "QuestSim.h"
+#include "../util/Hash64.h"
+#include "../util/Parallel.h"
+
+namespace arena2 {
+
+static bool IsWorldTrigger(uint16_t opCode) {
+    switch (opCode) {
+    case 0x00: case 0x01: case 0x02: case 0x03: case 0x15: case 0x1A: case 0x1C: case 0x1D:
+    case 0x1E: case 0x1F: case 0x27: case 0x2B: case 0x39: case 0x46: case 0x49: case 0x4D:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static QbnInstrKind KindForOpCode(uint16_t opCode) {
+    if (IsWorldTrigger(opCode)) return QbnInstrKind::Trigger;
+    switch (opCode) {
+    case 0x06: case 0x07: return QbnInstrKind::SetStates;
+    case 0x0C: return QbnInstrKind::StartTimer;
+    case 0x0D: return QbnInstrKind::StopTimer;
+    case 0x22: return QbnInstrKind::RandomState;
+    case 0x23: return QbnInstrKind::CycleState;
+    case 0x34: return QbnInstrKind::And;
+    case 0x35: return QbnInstrKind::Or;
+    default: return QbnInstrKind::Action;
+    }
+}
+
+void QbnProgram::Compile(const QuestQbn& qbn) {
+    stateCount = qbn.states.size();
+    instrs.clear();
+    timers.clear();
+    locations.clear();
+    triggerCount = 0;
+
+    auto stateOf = [&](const QbnSubRecord& sr) -> int32_t {
+        if (sr.sectionId != 9) return -1;
+        const int rec = sr.LinkedIndex();
+        return (rec >= 0 && static_cast<size_t>(rec) < stateCount) ? rec : -1;
+    };
+
+    for (const auto& t : qbn.timers) {
+        QbnTimerSpec spec;
+        spec.minTicks = static_cast<uint32_t>(std::max<int32_t>(t.minimum, 1));
+        spec.maxTicks = std::max(spec.minTicks, static_cast<uint32_t>(std::max<int32_t>(t.maximum, 1)));
+        if (t.link1 >= 0 && static_cast<size_t>(t.link1) < stateCount) spec.expiryState = t.link1;
+        timers.push_back(spec);
+    }
+    for (const auto& l : qbn.locations) locations.push_back(l.locationIndex);
+
+    instrs.reserve(qbn.opcodes.size());
+    for (size_t o = 0; o < qbn.opcodes.size() && o <= 0xFFFF; ++o) {
+        const auto& op = qbn.opcodes[o];
+        QbnInstr in;
+        in.kind = KindForOpCode(op.opCode);
+        in.opCode = op.opCode;
+        in.opcodeIndex = static_cast<uint16_t>(o);
+        in.first = stateOf(op.sub[0]);
+        in.firstNegated = op.sub[0].notFlag != 0;
+
+        const size_t n = std::min<size_t>(op.records, 5);
+        for (size_t i = 1; i < n; ++i) {
+            const auto& sr = op.sub[i];
+            if (const int32_t s = stateOf(sr); s >= 0) {
+                in.operands[in.operandCount++] = { static_cast<uint16_t>(s), sr.notFlag != 0 };
+            } else if (sr.sectionId == 4 && in.location == 0xFFFF) {
+                const int rec = sr.LinkedIndex();
+                if (rec >= 0 && qbn.FindLocation(static_cast<uint16_t>(rec))) in.location = static_cast<uint16_t>(rec);
+            } else if (sr.sectionId == 6 && in.timer < 0) {
+                const int rec = sr.LinkedIndex();
+                auto it = rec >= 0 ? qbn.timerByIndex.find(static_cast<uint16_t>(rec)) : qbn.timerByIndex.end();
+                if (it != qbn.timerByIndex.end()) in.timer = static_cast<int32_t>(it->second);
+            }
+        }
+
+        // Op-codes missing the operand they act on do nothing.
+        switch (in.kind) {
+        case QbnInstrKind::Trigger:
+        case QbnInstrKind::And:
+        case QbnInstrKind::Or:
+            if (in.first < 0 || (in.kind != QbnInstrKind::Trigger && in.operandCount == 0)) in.kind = QbnInstrKind::Action;
+            break;
+        case QbnInstrKind::SetStates:
+        case QbnInstrKind::RandomState:
+        case QbnInstrKind::CycleState:
+            if (in.operandCount == 0) in.kind = QbnInstrKind::Action;
+            break;
+        case QbnInstrKind::StartTimer:
+        case QbnInstrKind::StopTimer:
+            if (in.timer < 0) in.kind = QbnInstrKind::Action;
+            break;
+        default:
+            break;
+        }
+        if (in.kind == QbnInstrKind::Trigger) triggerCount++;
+        instrs.push_back(in);
+    }
+}
+
+void QbnDefaultWorld::BeginRun(const QbnProgram&, QbnRng&) {
+    m_pcLocation = 0xFFFF;
+}
+
+void QbnDefaultWorld::BeginTick(const QbnProgram& program, uint32_t, QbnRng& rng) {
+    if (!program.locations.empty()) m_pcLocation = program.locations[rng.Below(static_cast<uint32_t>(program.locations.size()))];
+}
+
+bool QbnDefaultWorld::Triggered(const QbnInstr& instr, QbnRng& rng) {
+    if (instr.opCode == 0x2B && instr.location != 0xFFFF) return instr.location == m_pcLocation;
+    return rng.Below(m_triggerOdds) == 0;
+}
+
+uint32_t QbnDefaultWorld::TimerTicks(const QbnTimerSpec& timer, QbnRng& rng) {
+    return timer.minTicks + rng.Below(timer.maxTicks - timer.minTicks + 1);
+}
+
+namespace {
+
+// Per-worker buffers, reused across runs so a playthrough allocates nothing.
+struct QbnRun {
+    std::vector<uint64_t> bits;
+    std::vector<uint64_t> ever;
+    std::vector<uint8_t> gateWas;
+    std::vector<uint8_t> cycleNext;
+    std::vector<uint32_t> timerLeft;
+    bool changed{};
+
+    bool Test(size_t s) const { return (bits[s >> 6] >> (s & 63)) & 1; }
+    void Set(size_t s, bool on) {
+        const uint64_t mask = 1ull << (s & 63);
+        uint64_t& w = bits[s >> 6];
+        if (((w & mask) != 0) == on) return;
+        w ^= mask;
+        changed = true;
+        if (on) ever[s >> 6] |= mask;
+    }
+
+    void Execute(const QbnProgram& p, QbnWorld& world, QbnRng& rng, uint32_t maxTicks, QuestSimStats& stats);
+};
+
+void QbnRun::Execute(const QbnProgram& p, QbnWorld& world, QbnRng& rng, uint32_t maxTicks, QuestSimStats& stats) {
+    const size_t words = (p.stateCount + 63) / 64;
+    bits.assign(words, 0);
+    ever.assign(words, 0);
+    gateWas.assign(p.instrs.size(), 0);
+    cycleNext.assign(p.instrs.size(), 0);
+    timerLeft.assign(p.timers.size(), 0);
+    if (p.stateCount) Set(0, true);
+
+    world.BeginRun(p, rng);
+    uint32_t lastChange = 0;
+    bool completed = false;
+    for (uint32_t tick = 1; tick <= maxTicks; ++tick) {
+        world.BeginTick(p, tick, rng);
+        changed = false;
+
+        for (size_t t = 0; t < timerLeft.size(); ++t) {
+            if (timerLeft[t] && --timerLeft[t] == 0 && p.timers[t].expiryState >= 0) Set(static_cast<size_t>(p.timers[t].expiryState), true);
+        }
+
+        size_t armed = 0;
+        for (size_t i = 0; i < p.instrs.size(); ++i) {
+            const QbnInstr& in = p.instrs[i];
+            switch (in.kind) {
+            case QbnInstrKind::Trigger:
+                if (Test(in.first)) break;
+                if (world.Triggered(in, rng)) Set(in.first, true);
+                else armed++;
+                break;
+            case QbnInstrKind::And:
+            case QbnInstrKind::Or: {
+                if (Test(in.first)) break;
+                bool all = true, any = false;
+                for (uint8_t k = 0; k < in.operandCount; ++k) {
+                    const bool v = Test(in.operands[k].state) != in.operands[k].negate;
+                    all = all && v;
+                    any = any || v;
+                }
+                if (in.kind == QbnInstrKind::And ? all : any) Set(in.first, true);
+                break;
+            }
+            default: {
+                const bool gate = in.first < 0 || Test(in.first) != in.firstNegated;
+                const bool rising = gate && !gateWas[i];
+                gateWas[i] = gate;
+                if (!rising) break;
+
+                switch (in.kind) {
+                case QbnInstrKind::SetStates:
+                    for (uint8_t k = 0; k < in.operandCount; ++k) Set(in.operands[k].state, !in.operands[k].negate);
+                    break;
+                case QbnInstrKind::RandomState:
+                    Set(in.operands[std::min<uint32_t>(world.PickRandomState(in.operandCount, rng), in.operandCount - 1u)].state, true);
+                    break;
+                case QbnInstrKind::CycleState:
+                    Set(in.operands[cycleNext[i]].state, true);
+                    cycleNext[i] = static_cast<uint8_t>((cycleNext[i] + 1) % in.operandCount);
+                    break;
+                case QbnInstrKind::StartTimer:
+                    timerLeft[in.timer] = std::max(1u, world.TimerTicks(p.timers[in.timer], rng));
+                    break;
+                case QbnInstrKind::StopTimer:
+                    timerLeft[in.timer] = 0;
+                    break;
+                default:
+                    break;
+                }
+                break;
+            }
+            }
+        }
+
+        if (changed) {
+            lastChange = tick;
+        } else if (armed == 0 && std::all_of(timerLeft.begin(), timerLeft.end(), [](uint32_t t) { return t == 0; })) {
+            completed = true;
+            break;
+        }
+    }
+
+    stats.runs++;
+    if (completed) {
+        stats.completed++;
+        stats.completionTicks += lastChange;
+    }
+    for (size_t s = 0; s < p.stateCount; ++s) {
+        if ((ever[s >> 6] >> (s & 63)) & 1) stats.stateReached[s]++;
+    }
+}
+
+}
+
+std::vector<QuestSimStats> SimulateQuests(const QuestCatalog& catalog, const QuestSimOptions& options) {
+    const size_t questCount = catalog.quests.size();
+    std::vector<QuestSimStats> out(questCount);
+    std::vector<QbnProgram> programs(questCount);
+
+    // Runs are handed out in fixed batches; each batch fills its own stats, merged in order afterwards.
+    static constexpr uint32_t kBatch = 256;
+    struct Job {
+        uint32_t quest;
+        uint32_t firstRun;
+        QuestSimStats stats;
+    };
+    std::vector<Job> jobs;
+    for (size_t q = 0; q < questCount; ++q) {
+        if (!catalog.quests[q].qbnLoaded) continue;
+        programs[q].Compile(catalog.quests[q].qbn);
+        out[q].stateReached.assign(programs[q].stateCount, 0);
+        for (uint32_t r = 0; r < options.runs; r += kBatch) jobs.push_back({ static_cast<uint32_t>(q), r, {} });
+    }
+
+    const size_t workers = std::min(options.workerCount ? options.workerCount : winutil::DefaultWorkerCount(), std::max<size_t>(jobs.size(), 1));
+    std::vector<std::unique_ptr<QbnWorld>> worlds(workers);
+    std::vector<QbnRun> scratch(workers);
+    for (auto& w : worlds) w = options.makeWorld ? options.makeWorld() : std::make_unique<QbnDefaultWorld>(options.triggerOdds);
+
+    winutil::ParallelFor(jobs.size(), workers, [&](size_t j, size_t worker) {
+        Job& job = jobs[j];
+        const QbnProgram& p = programs[job.quest];
+        job.stats.stateReached.assign(p.stateCount, 0);
+        const uint32_t end = std::min(options.runs, job.firstRun + kBatch);
+        for (uint32_t r = job.firstRun; r < end; ++r) {
+            const uint64_t key[3] = { options.seed, job.quest, r };
+            QbnRng rng(winutil::Hash64(key, sizeof(key)));
+            scratch[worker].Execute(p, *worlds[worker], rng, options.maxTicks, job.stats);
+        }
+    });
+
+    for (const Job& job : jobs) {
+        QuestSimStats& s = out[job.quest];
+        s.runs += job.stats.runs;
+        s.completed += job.stats.completed;
+        s.completionTicks += job.stats.completionTicks;
+        for (size_t i = 0; i < s.stateReached.size(); ++i) s.stateReached[i] += job.stats.stateReached[i];
+    }
+    return out;
+}
+
+} // namespace arena2
@@ -0,0 +1,123 @@
+#pragma once
+#include "../pch.h"
+#include <functional>
+#include <memory>
+#include "QuestCatalog.h"
+
+namespace arena2 {
+
+// Headless model of the QBN state machine, for asking "can this stage ever be reached" without the game.
+//
+// Quest state is one bit per QbnState; state 0 starts set. Every tick the op-codes run in file order:
+//  - world triggers (PC at location, PC meets NPC, kill counts, ...) set their first operand once the world
+//    stub reports the event; they stay armed until that state is set,
+//  - AND/OR States (0x34/0x35) set their first operand while the other operands hold,
+//  - everything else fires once each time its first operand (the gate) becomes true: States (0x06/0x07) set
+//    or, with the NOT flag, clear their other state operands, Random State (0x22) sets one of them,
+//    Cycle State (0x23) the next one in turn, and Start/Stop Timer (0x0C/0x0D) drive the timer operand, which
+//    sets the state in its link1 field when it runs out. Other actions (messages, topics, items) have no effect.
+// A run completes when a tick changes nothing, no timer is running and every trigger has fired.
+// This follows how the tools read op-codes, not a disassembly of the engine, so treat results as a model.
+
+struct QbnRng {
+    uint64_t state{};
+
+    explicit QbnRng(uint64_t seed) : state(seed) {}
+    uint64_t Next() {   // splitmix64
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    uint32_t Below(uint32_t n) { return n ? static_cast<uint32_t>(((Next() >> 32) * n) >> 32) : 0; }
+};
+
+enum class QbnInstrKind : uint8_t { Trigger, And, Or, SetStates, RandomState, CycleState, StartTimer, StopTimer, Action };
+
+struct QbnOperand {
+    uint16_t state{};
+    bool negate{};
+};
+
+struct QbnInstr {
+    QbnInstrKind kind{};
+    uint16_t opCode{};
+    uint16_t opcodeIndex{};   // into QuestQbn::opcodes
+    int32_t first{ -1 };      // state of sub-record 0: the output of triggers and AND/OR, the gate of the rest
+    bool firstNegated{};
+    uint16_t location{ 0xFFFF };   // location operand, for PC at Location
+    int32_t timer{ -1 };           // into QbnProgram::timers
+    uint8_t operandCount{};
+    std::array<QbnOperand, 4> operands{};   // state operands of sub-records 1..4
+};
+
+struct QbnTimerSpec {
+    uint32_t minTicks{ 1 };
+    uint32_t maxTicks{ 1 };
+    int32_t expiryState{ -1 };
+};
+
+// A QBN's op-codes with sub-records resolved to state, timer and location indices, ready to run many times.
+struct QbnProgram {
+    size_t stateCount{};
+    std::vector<QbnInstr> instrs;
+    std::vector<QbnTimerSpec> timers;
+    std::vector<uint16_t> locations;   // location indices the PC can visit
+    size_t triggerCount{};
+
+    void Compile(const QuestQbn& qbn);
+};
+
+// World stubs. One instance serves one worker thread at a time, so it may keep per-run state (where the PC is).
+class QbnWorld {
+public:
+    virtual ~QbnWorld() = default;
+    virtual void BeginRun(const QbnProgram&, QbnRng&) {}
+    virtual void BeginTick(const QbnProgram&, uint32_t /*tick*/, QbnRng&) {}
+    // Whether the event a trigger waits for happens this tick.
+    virtual bool Triggered(const QbnInstr& instr, QbnRng& rng) = 0;
+    virtual uint32_t TimerTicks(const QbnTimerSpec& timer, QbnRng& rng) = 0;
+    virtual uint32_t PickRandomState(uint32_t count, QbnRng& rng) { return rng.Below(count); }
+};
+
+// The PC wanders between the quest's locations (PC at Location fires where it stands); any other trigger
+// fires with a fixed chance per tick; timers last a uniform number of ticks between their minimum and maximum.
+class QbnDefaultWorld : public QbnWorld {
+public:
+    explicit QbnDefaultWorld(uint32_t triggerOdds = 8) : m_triggerOdds(triggerOdds ? triggerOdds : 1) {}
+
+    void BeginRun(const QbnProgram& program, QbnRng& rng) override;
+    void BeginTick(const QbnProgram& program, uint32_t tick, QbnRng& rng) override;
+    bool Triggered(const QbnInstr& instr, QbnRng& rng) override;
+    uint32_t TimerTicks(const QbnTimerSpec& timer, QbnRng& rng) override;
+
+private:
+    uint32_t m_triggerOdds;       // a trigger fires with probability 1/m_triggerOdds per tick
+    uint16_t m_pcLocation{ 0xFFFF };
+};
+
+struct QuestSimOptions {
+    uint32_t runs{ 1000 };         // playthroughs per quest
+    uint64_t seed{ 1 };
+    uint32_t maxTicks{ 5000 };     // runs still busy after this many ticks count as unfinished
+    size_t workerCount{};          // 0 = one per hardware thread
+    uint32_t triggerOdds{ 8 };     // for the default world
+    std::function<std::unique_ptr<QbnWorld>()> makeWorld;   // empty = QbnDefaultWorld(triggerOdds)
+};
+
+struct QuestSimStats {
+    uint32_t runs{};
+    uint32_t completed{};
+    uint64_t completionTicks{};          // summed over completed runs
+    std::vector<uint32_t> stateReached;  // per state: runs in which it was ever set
+
+    double AverageTicks() const { return completed ? double(completionTicks) / completed : 0.0; }
+    size_t DeadStates() const { return static_cast<size_t>(std::count(stateReached.begin(), stateReached.end(), 0u)); }
+};
+
+// Runs options.runs seeded playthroughs of every loaded quest across worker threads. Each run's seed depends
+// only on options.seed, the quest index and the run number, so results do not depend on the worker count.
+// Quests whose QBN did not load get empty stats.
+std::vector<QuestSimStats> SimulateQuests(const QuestCatalog& catalog, const QuestSimOptions& options);
+
+} // namespace arena2
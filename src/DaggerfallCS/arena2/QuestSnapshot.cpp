@@ -0,0 +1,557 @@
+#include "pch.h"
+#include "QuestSnapshot.h"
+#include "TextArena.h"
+#include "../util/Hash64.h"
+#include "../util/MappedFile.h"
+
+namespace arena2 {
+
+static constexpr char kMagic[8] = { 'D', 'F', 'Q', 'U', 'E', 'S', 'T', 'S' };
+static constexpr uint32_t kVersion = 1;
+
+// Identity of one quest's source files when the snapshot was written.
+struct QuestStamp {
+    std::string baseName;
+    uint64_t qbnSize{};
+    int64_t qbnMtime{};
+    bool hasQrc{};
+    uint64_t qrcSize{};
+    int64_t qrcMtime{};
+
+    bool operator==(const QuestStamp&) const = default;
+};
+
+static bool StampFile(const std::filesystem::path& path, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto t = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    mtime = static_cast<int64_t>(t.time_since_epoch().count());
+    return true;
+}
+
+static bool StampQuest(const std::string& baseName, const std::filesystem::path& qbnPath, const std::filesystem::path& qrcPath, QuestStamp& out) {
+    out = {};
+    out.baseName = baseName;
+    if (!StampFile(qbnPath, out.qbnSize, out.qbnMtime)) return false;
+    out.hasQrc = StampFile(qrcPath, out.qrcSize, out.qrcMtime);
+    if (!out.hasQrc) out.qrcSize = 0, out.qrcMtime = 0;
+    return true;
+}
+
+static bool StampQuest(const QuestEntry& q, QuestStamp& out) {
+    return StampQuest(q.baseName, q.qbnPath, q.qrcPath, out);
+}
+
+std::filesystem::path QuestSnapshotPath(const std::filesystem::path& cacheDir, const std::filesystem::path& questRoot) {
+    std::error_code ec;
+    std::wstring full = std::filesystem::absolute(questRoot, ec).wstring();
+    for (auto& c : full) c = (wchar_t)towupper(c);
+
+    wchar_t name[48]{};
+    swprintf_s(name, L"QUESTS-%016llX.qcat", (unsigned long long)winutil::Hash64(full.data(), full.size() * sizeof(wchar_t)));
+    return cacheDir / name;
+}
+
+// ---- Writing ----
+
+struct SnapshotWriter {
+    std::vector<uint8_t> out;
+    std::unordered_map<std::string, uint32_t> nameIds;
+    std::vector<const std::string*> names;   // by id
+
+    void Put(uint64_t v, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>((v >> (8 * i)) & 0xFF));
+    }
+    void PutString(std::string_view s) {
+        const size_t n = std::min<size_t>(s.size(), 0xFFFF);
+        Put(n, 2);
+        out.insert(out.end(), s.begin(), s.begin() + n);
+    }
+    void PutBlob(const std::vector<uint8_t>& b) {
+        Put(b.size(), 4);
+        out.insert(out.end(), b.begin(), b.end());
+    }
+    // Resolved variable names repeat across quests, so they are written as ids into one string table.
+    void PutNames(const std::vector<std::string>& v) {
+        Put(v.size(), 2);
+        for (const auto& s : v) {
+            auto [it, inserted] = nameIds.try_emplace(s, static_cast<uint32_t>(names.size()));
+            if (inserted) names.push_back(&it->first);
+            Put(it->second, 4);
+        }
+    }
+};
+
+static void WriteQbn(SnapshotWriter& w, const QuestQbn& qbn) {
+    w.PutBlob(qbn.fileBytes);
+
+    const auto& h = qbn.header;
+    w.Put(h.questId, 2);
+    w.Put(h.factionId, 2);
+    w.Put(h.resourceId, 2);
+    w.out.insert(w.out.end(), h.resourceFilename.begin(), h.resourceFilename.end());
+    w.Put(h.hasDebugInfo, 1);
+    for (auto c : h.sectionRecordCount) w.Put(c, 2);
+    for (auto o : h.sectionOffset) w.Put(o, 2);
+
+    w.Put(qbn.states.size(), 4);
+    for (const auto& s : qbn.states) {
+        w.Put(static_cast<uint16_t>(s.flagIndex), 2);
+        w.Put(s.isGlobal, 1);
+        w.Put(s.globalIndex, 1);
+        w.Put(s.textVarHash, 4);
+        w.PutNames(s.varNames);
+    }
+
+    w.Put(qbn.textVars.size(), 4);
+    for (const auto& tv : qbn.textVars) {
+        w.PutString(tv.nameLower);
+        w.Put(tv.sectionId, 1);
+        w.Put(tv.recordId, 2);
+        w.Put(tv.recordPtr, 4);
+        w.Put(tv.hash, 4);
+        w.PutNames(tv.varNames);
+    }
+
+    w.Put(qbn.opcodes.size(), 4);
+    for (const auto& op : qbn.opcodes) {
+        w.Put(op.opCode, 2);
+        w.Put(op.flags, 2);
+        w.Put(op.records, 2);
+        for (const auto& s : op.sub) {
+            w.Put(s.notFlag, 1);
+            w.Put(s.localPtr, 4);
+            w.Put(s.sectionId, 2);
+            w.Put(s.value, 4);
+            w.Put(s.objectPtr, 4);
+        }
+        w.Put(op.messageId, 2);
+        w.Put(op.lastUpdate, 4);
+        w.Put(op.fileOffset, 4);
+    }
+
+    w.Put(qbn.items.size(), 4);
+    for (const auto& it : qbn.items) {
+        w.Put(static_cast<uint16_t>(it.itemIndex), 2);
+        w.Put(it.reward, 1);
+        w.Put(it.itemCategory, 2);
+        w.Put(it.itemCategoryIndex, 2);
+        w.Put(it.textVarHash, 4);
+        w.Put(it.textRecordId1, 2);
+        w.Put(it.textRecordId2, 2);
+        w.PutNames(it.varNames);
+    }
+
+    w.Put(qbn.npcs.size(), 4);
+    for (const auto& n : qbn.npcs) {
+        w.Put(static_cast<uint16_t>(n.npcIndex), 2);
+        w.Put(n.gender, 1);
+        w.Put(n.faceIndex, 1);
+        w.Put(n.unknown1, 2);
+        w.Put(n.factionIndex, 2);
+        w.Put(n.textVarHash, 4);
+        w.Put(n.textRecordId1, 2);
+        w.Put(n.textRecordId2, 2);
+        w.PutNames(n.varNames);
+    }
+
+    w.Put(qbn.locations.size(), 4);
+    for (const auto& l : qbn.locations) {
+        w.Put(l.locationIndex, 2);
+        w.Put(l.flags, 1);
+        w.Put(l.generalLocation, 1);
+        w.Put(l.fineLocation, 2);
+        w.Put(static_cast<uint16_t>(l.locationType), 2);
+        w.Put(static_cast<uint16_t>(l.doorSelector), 2);
+        w.Put(l.unknown2, 2);
+        w.Put(l.textVarHash, 4);
+        w.Put(l.objPtr, 4);
+        w.Put(l.textRecordId1, 2);
+        w.Put(l.textRecordId2, 2);
+        w.PutNames(l.varNames);
+    }
+
+    w.Put(qbn.timers.size(), 4);
+    for (const auto& t : qbn.timers) {
+        w.Put(static_cast<uint16_t>(t.timerIndex), 2);
+        w.Put(t.flags, 2);
+        w.Put(t.type, 1);
+        w.Put(static_cast<uint32_t>(t.minimum), 4);
+        w.Put(static_cast<uint32_t>(t.maximum), 4);
+        w.Put(t.started, 4);
+        w.Put(t.duration, 4);
+        w.Put(static_cast<uint32_t>(t.link1), 4);
+        w.Put(static_cast<uint32_t>(t.link2), 4);
+        w.Put(t.textVarHash, 4);
+        w.PutNames(t.varNames);
+    }
+
+    w.Put(qbn.mobs.size(), 4);
+    for (const auto& m : qbn.mobs) {
+        w.Put(m.mobIndex, 1);
+        w.Put(m.null1, 2);
+        w.Put(m.mobType, 1);
+        w.Put(m.mobCount, 2);
+        w.Put(m.textVarHash, 4);
+        w.Put(m.null2, 4);
+        w.PutNames(m.varNames);
+    }
+}
+
+static void WriteQrc(SnapshotWriter& w, const TextRsc& qrc) {
+    w.PutBlob(qrc.fileBytes);
+    w.Put(qrc.records.size(), 4);
+    for (const auto& r : qrc.records) {
+        w.Put(r.recordId, 2);
+        w.Put(r.start, 4);
+        w.Put(r.end, 4);
+    }
+}
+
+bool BuildQuestSnapshot(const QuestCatalog& catalog, QuestSnapshotImage& out, std::wstring* err) {
+    if (catalog.quests.empty() || catalog.arena2Root.empty()) {
+        if (err) *err = L"No quests loaded.";
+        return false;
+    }
+
+    out = {};
+    out.questRoot = catalog.arena2Root;
+    out.hashesFingerprint = catalog.hashesFingerprint;
+    out.quests.reserve(catalog.quests.size());
+
+    SnapshotWriter body;
+    for (const auto& q : catalog.quests) {
+        out.quests.push_back({ q.baseName, q.qbnPath, q.qrcPath, q.qbnLoaded, q.qbn.fileBytes.size(), q.qrcLoaded, q.qrc.fileBytes.size() });
+
+        body.Put(q.qbnLoaded ? 1 : 0, 1);
+        if (q.qbnLoaded) WriteQbn(body, q.qbn);
+        body.PutString(q.displayName);
+        body.Put(q.displayNameSourceRecord, 2);
+        body.Put(q.qrcLoaded ? 1 : 0, 1);
+        if (q.qrcLoaded) WriteQrc(body, q.qrc);
+    }
+    out.names.reserve(body.names.size());
+    for (const auto* s : body.names) out.names.push_back(*s);
+    out.body = std::move(body.out);
+    return true;
+}
+
+bool WriteQuestSnapshot(const std::filesystem::path& cacheDir, const QuestSnapshotImage& image, std::wstring* err) {
+    std::vector<QuestStamp> stamps(image.quests.size());
+    for (size_t i = 0; i < image.quests.size(); ++i) {
+        const auto& q = image.quests[i];
+        // The stamps describe the files as they are now, so they must still be the bytes that were parsed.
+        if (!StampQuest(q.baseName, q.qbnPath, q.qrcPath, stamps[i]) ||
+            (q.qbnLoaded && stamps[i].qbnSize != q.qbnSize) ||
+            (q.qrcLoaded && (!stamps[i].hasQrc || stamps[i].qrcSize != q.qrcSize))) {
+            if (err) *err = L"Quest files changed since they were loaded: " + q.qbnPath.wstring();
+            return false;
+        }
+    }
+
+    SnapshotWriter w;
+    w.out.reserve(image.body.size() + 64 * stamps.size() + 4096);
+    w.out.assign(kMagic, kMagic + sizeof(kMagic));
+    w.Put(kVersion, 4);
+    w.Put(image.hashesFingerprint, 8);
+    w.Put(stamps.size(), 4);
+    for (const auto& s : stamps) {
+        w.PutString(s.baseName);
+        w.Put(s.qbnSize, 8);
+        w.Put(static_cast<uint64_t>(s.qbnMtime), 8);
+        w.Put(s.hasQrc ? 1 : 0, 1);
+        w.Put(s.qrcSize, 8);
+        w.Put(static_cast<uint64_t>(s.qrcMtime), 8);
+    }
+    w.Put(image.names.size(), 4);
+    for (const auto& s : image.names) w.PutString(s);
+    w.out.insert(w.out.end(), image.body.begin(), image.body.end());
+    w.Put(winutil::Hash64(w.out.data(), w.out.size()), 8);
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    const auto finalPath = QuestSnapshotPath(cacheDir, image.questRoot);
+    auto tmpPath = finalPath;
+    tmpPath += L".tmp";
+    {
+        std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            if (err) *err = L"Failed to write " + tmpPath.wstring();
+            return false;
+        }
+        f.write(reinterpret_cast<const char*>(w.out.data()), (std::streamsize)w.out.size());
+        if (!f.good()) {
+            if (err) *err = L"Failed to write " + tmpPath.wstring();
+            return false;
+        }
+    }
+    std::filesystem::rename(tmpPath, finalPath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        if (err) *err = L"Failed to replace " + finalPath.wstring();
+        return false;
+    }
+    return true;
+}
+
+bool SaveQuestSnapshot(const std::filesystem::path& cacheDir, const QuestCatalog& catalog, std::wstring* err) {
+    QuestSnapshotImage image;
+    return BuildQuestSnapshot(catalog, image, err) && WriteQuestSnapshot(cacheDir, image, err);
+}
+
+// ---- Reading ----
+
+struct SnapshotReader {
+    const uint8_t* p{};
+    const uint8_t* end{};
+    const std::vector<std::string>* names{};
+    bool ok{ true };
+
+    uint64_t Read(size_t bytes) {
+        if (!ok || size_t(end - p) < bytes) { ok = false; return 0; }
+        uint64_t v = 0;
+        for (size_t i = 0; i < bytes; ++i) v |= uint64_t(p[i]) << (8 * i);
+        p += bytes;
+        return v;
+    }
+    // Element counts are checked against the bytes left, so a bad count cannot trigger a huge allocation.
+    size_t ReadCount() {
+        const size_t n = static_cast<size_t>(Read(4));
+        if (n > size_t(end - p)) ok = false;
+        return ok ? n : 0;
+    }
+    std::string ReadString() {
+        size_t n = static_cast<size_t>(Read(2));
+        if (!ok || size_t(end - p) < n) { ok = false; return {}; }
+        std::string s(reinterpret_cast<const char*>(p), n);
+        p += n;
+        return s;
+    }
+    void ReadBlob(std::vector<uint8_t>& out) {
+        size_t n = static_cast<size_t>(Read(4));
+        if (!ok || size_t(end - p) < n) { ok = false; return; }
+        out.assign(p, p + n);
+        p += n;
+    }
+    void ReadNames(std::vector<std::string>& out) {
+        const size_t n = static_cast<size_t>(Read(2));
+        out.clear();
+        out.reserve(n);
+        for (size_t i = 0; i < n && ok; ++i) {
+            const size_t id = static_cast<size_t>(Read(4));
+            if (id >= names->size()) { ok = false; return; }
+            out.push_back((*names)[id]);
+        }
+    }
+};
+
+static void ReadQbn(SnapshotReader& r, QuestQbn& qbn) {
+    r.ReadBlob(qbn.fileBytes);
+
+    auto& h = qbn.header;
+    h.questId = static_cast<uint16_t>(r.Read(2));
+    h.factionId = static_cast<uint16_t>(r.Read(2));
+    h.resourceId = static_cast<uint16_t>(r.Read(2));
+    for (auto& c : h.resourceFilename) c = static_cast<uint8_t>(r.Read(1));
+    h.hasDebugInfo = static_cast<uint8_t>(r.Read(1));
+    for (auto& c : h.sectionRecordCount) c = static_cast<uint16_t>(r.Read(2));
+    for (auto& o : h.sectionOffset) o = static_cast<uint16_t>(r.Read(2));
+
+    qbn.states.resize(r.ReadCount());
+    for (auto& s : qbn.states) {
+        s.flagIndex = static_cast<int16_t>(r.Read(2));
+        s.isGlobal = static_cast<uint8_t>(r.Read(1));
+        s.globalIndex = static_cast<uint8_t>(r.Read(1));
+        s.textVarHash = static_cast<uint32_t>(r.Read(4));
+        r.ReadNames(s.varNames);
+    }
+
+    qbn.textVars.resize(r.ReadCount());
+    for (auto& tv : qbn.textVars) {
+        tv.nameLower = r.ReadString();
+        tv.sectionId = static_cast<uint8_t>(r.Read(1));
+        tv.recordId = static_cast<uint16_t>(r.Read(2));
+        tv.recordPtr = static_cast<uint32_t>(r.Read(4));
+        tv.hash = static_cast<uint32_t>(r.Read(4));
+        r.ReadNames(tv.varNames);
+    }
+
+    qbn.opcodes.resize(r.ReadCount());
+    for (auto& op : qbn.opcodes) {
+        op.opCode = static_cast<uint16_t>(r.Read(2));
+        op.flags = static_cast<uint16_t>(r.Read(2));
+        op.records = static_cast<uint16_t>(r.Read(2));
+        for (auto& s : op.sub) {
+            s.notFlag = static_cast<uint8_t>(r.Read(1));
+            s.localPtr = static_cast<uint32_t>(r.Read(4));
+            s.sectionId = static_cast<uint16_t>(r.Read(2));
+            s.value = static_cast<uint32_t>(r.Read(4));
+            s.objectPtr = static_cast<uint32_t>(r.Read(4));
+        }
+        op.messageId = static_cast<uint16_t>(r.Read(2));
+        op.lastUpdate = static_cast<uint32_t>(r.Read(4));
+        op.fileOffset = static_cast<uint32_t>(r.Read(4));
+    }
+
+    qbn.items.resize(r.ReadCount());
+    for (auto& it : qbn.items) {
+        it.itemIndex = static_cast<int16_t>(r.Read(2));
+        it.reward = static_cast<uint8_t>(r.Read(1));
+        it.itemCategory = static_cast<uint16_t>(r.Read(2));
+        it.itemCategoryIndex = static_cast<uint16_t>(r.Read(2));
+        it.textVarHash = static_cast<uint32_t>(r.Read(4));
+        it.textRecordId1 = static_cast<uint16_t>(r.Read(2));
+        it.textRecordId2 = static_cast<uint16_t>(r.Read(2));
+        r.ReadNames(it.varNames);
+    }
+
+    qbn.npcs.resize(r.ReadCount());
+    for (auto& n : qbn.npcs) {
+        n.npcIndex = static_cast<int16_t>(r.Read(2));
+        n.gender = static_cast<uint8_t>(r.Read(1));
+        n.faceIndex = static_cast<uint8_t>(r.Read(1));
+        n.unknown1 = static_cast<uint16_t>(r.Read(2));
+        n.factionIndex = static_cast<uint16_t>(r.Read(2));
+        n.textVarHash = static_cast<uint32_t>(r.Read(4));
+        n.textRecordId1 = static_cast<uint16_t>(r.Read(2));
+        n.textRecordId2 = static_cast<uint16_t>(r.Read(2));
+        r.ReadNames(n.varNames);
+    }
+
+    qbn.locations.resize(r.ReadCount());
+    for (auto& l : qbn.locations) {
+        l.locationIndex = static_cast<uint16_t>(r.Read(2));
+        l.flags = static_cast<uint8_t>(r.Read(1));
+        l.generalLocation = static_cast<uint8_t>(r.Read(1));
+        l.fineLocation = static_cast<uint16_t>(r.Read(2));
+        l.locationType = static_cast<int16_t>(r.Read(2));
+        l.doorSelector = static_cast<int16_t>(r.Read(2));
+        l.unknown2 = static_cast<uint16_t>(r.Read(2));
+        l.textVarHash = static_cast<uint32_t>(r.Read(4));
+        l.objPtr = static_cast<uint32_t>(r.Read(4));
+        l.textRecordId1 = static_cast<uint16_t>(r.Read(2));
+        l.textRecordId2 = static_cast<uint16_t>(r.Read(2));
+        r.ReadNames(l.varNames);
+    }
+
+    qbn.timers.resize(r.ReadCount());
+    for (auto& t : qbn.timers) {
+        t.timerIndex = static_cast<int16_t>(r.Read(2));
+        t.flags = static_cast<uint16_t>(r.Read(2));
+        t.type = static_cast<uint8_t>(r.Read(1));
+        t.minimum = static_cast<int32_t>(r.Read(4));
+        t.maximum = static_cast<int32_t>(r.Read(4));
+        t.started = static_cast<uint32_t>(r.Read(4));
+        t.duration = static_cast<uint32_t>(r.Read(4));
+        t.link1 = static_cast<int32_t>(r.Read(4));
+        t.link2 = static_cast<int32_t>(r.Read(4));
+        t.textVarHash = static_cast<uint32_t>(r.Read(4));
+        r.ReadNames(t.varNames);
+    }
+
+    qbn.mobs.resize(r.ReadCount());
+    for (auto& m : qbn.mobs) {
+        m.mobIndex = static_cast<uint8_t>(r.Read(1));
+        m.null1 = static_cast<uint16_t>(r.Read(2));
+        m.mobType = static_cast<uint8_t>(r.Read(1));
+        m.mobCount = static_cast<uint16_t>(r.Read(2));
+        m.textVarHash = static_cast<uint32_t>(r.Read(4));
+        m.null2 = static_cast<uint32_t>(r.Read(4));
+        r.ReadNames(m.varNames);
+    }
+
+    qbn.BuildIndexMaps();
+}
+
+static void ReadQrc(SnapshotReader& r, TextRsc& qrc) {
+    r.ReadBlob(qrc.fileBytes);
+    qrc.strings = std::make_shared<TextArena>();
+    qrc.records.resize(r.ReadCount());
+    for (auto& rec : qrc.records) {
+        rec.recordId = static_cast<uint16_t>(r.Read(2));
+        rec.start = static_cast<uint32_t>(r.Read(4));
+        rec.end = static_cast<uint32_t>(r.Read(4));
+        rec.arena = qrc.strings.get();
+        if (rec.start > rec.end || rec.end > qrc.fileBytes.size()) r.ok = false;
+    }
+    qrc.BuildIdIndex();
+}
+
+bool LoadQuestSnapshot(const std::filesystem::path& cacheDir, QuestCatalog& catalog) {
+    if (catalog.quests.empty()) return false;
+
+    const auto path = QuestSnapshotPath(cacheDir, catalog.arena2Root);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) return false;
+
+    // One mapping of the whole snapshot; everything below is decoded from it.
+    auto file = winutil::MappedFile::Open(path, nullptr);
+    if (!file || file->Size() < sizeof(kMagic) + 8 || memcmp(file->Data(), kMagic, sizeof(kMagic)) != 0) return false;
+
+    const size_t bodySize = file->Size() - 8;
+    SnapshotReader tail{ file->Data() + bodySize, file->Data() + file->Size() };
+    if (tail.Read(8) != winutil::Hash64(file->Data(), bodySize)) return false;
+
+    SnapshotReader r{ file->Data() + sizeof(kMagic), file->Data() + bodySize };
+    if (r.Read(4) != kVersion) return false;
+    if (r.Read(8) != catalog.hashesFingerprint) return false;
+    if (r.ReadCount() != catalog.quests.size()) return false;
+
+    for (const auto& q : catalog.quests) {
+        QuestStamp stored;
+        stored.baseName = r.ReadString();
+        stored.qbnSize = r.Read(8);
+        stored.qbnMtime = static_cast<int64_t>(r.Read(8));
+        stored.hasQrc = r.Read(1) != 0;
+        stored.qrcSize = r.Read(8);
+        stored.qrcMtime = static_cast<int64_t>(r.Read(8));
+
+        QuestStamp current;
+        if (!r.ok || !StampQuest(q, current) || !(current == stored)) return false;
+    }
+
+    std::vector<std::string> names(r.ReadCount());
+    for (auto& s : names) s = r.ReadString();
+    r.names = &names;
+
+    // Decoded into scratch entries first, so a snapshot that turns out to be bad leaves the catalog as it was.
+    struct Decoded {
+        QuestQbn qbn;
+        TextRsc qrc;
+        std::string displayName;
+        uint16_t displayNameSourceRecord{};
+        bool qbnLoaded{};
+        bool qrcLoaded{};
+    };
+    std::vector<Decoded> decoded(catalog.quests.size());
+    for (size_t i = 0; i < decoded.size() && r.ok; ++i) {
+        auto& d = decoded[i];
+        d.qbn.sourcePath = catalog.quests[i].qbnPath;
+        d.qbnLoaded = r.Read(1) != 0;
+        if (d.qbnLoaded) ReadQbn(r, d.qbn);
+        d.displayName = r.ReadString();
+        d.displayNameSourceRecord = static_cast<uint16_t>(r.Read(2));
+        d.qrcLoaded = r.Read(1) != 0;
+        if (d.qrcLoaded) {
+            d.qrc.sourcePath = catalog.quests[i].qrcPath;
+            ReadQrc(r, d.qrc);
+        }
+    }
+    if (!r.ok || r.p != r.end) return false;
+
+    for (size_t i = 0; i < decoded.size(); ++i) {
+        auto& q = catalog.quests[i];
+        auto& d = decoded[i];
+        q.qbn = std::move(d.qbn);
+        q.qbnLoaded = d.qbnLoaded;
+        q.qrc = std::move(d.qrc);
+        q.qrcLoaded = d.qrcLoaded;
+        q.displayName = std::move(d.displayName);
+        q.displayNameSourceRecord = d.displayNameSourceRecord;
+    }
+    return true;
+}
+
+} // namespace arena2
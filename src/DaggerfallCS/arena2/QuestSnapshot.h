@@ -0,0 +1,40 @@
+#pragma once
+#include "../pch.h"
+#include "QuestCatalog.h"
+
+namespace arena2 {
+
+// Versioned cache of a parsed quest folder: every QBN section (variable names interned in a string table), the
+// derived display names and the loaded QRC files with their record tables. Stored as
+// <cacheDir>/QUESTS-<path hash>.qcat and only trusted when the QBN listing, each QBN/QRC file's size and mtime
+// and the VarHashCatalog fingerprint still match; the file itself carries a trailing content hash.
+std::filesystem::path QuestSnapshotPath(const std::filesystem::path& cacheDir, const std::filesystem::path& questRoot);
+
+// Fills the QBN/QRC state of catalog.quests, whose names and paths must already be set from the folder listing
+// (as must arena2Root and hashesFingerprint). Leaves the catalog untouched when there is no valid snapshot.
+bool LoadQuestSnapshot(const std::filesystem::path& cacheDir, QuestCatalog& catalog);
+bool SaveQuestSnapshot(const std::filesystem::path& cacheDir, const QuestCatalog& catalog, std::wstring* err);
+
+// SaveQuestSnapshot in two steps, for writing from a worker thread: BuildQuestSnapshot serializes the catalog
+// (memory only, no file access) and WriteQuestSnapshot stamps the source files and writes the result.
+struct QuestSnapshotImage {
+    struct Quest {
+        std::string baseName;
+        std::filesystem::path qbnPath;
+        std::filesystem::path qrcPath;
+        bool qbnLoaded{};
+        uint64_t qbnSize{};   // bytes that were parsed, checked against the file when stamping
+        bool qrcLoaded{};
+        uint64_t qrcSize{};
+    };
+    std::filesystem::path questRoot;
+    uint64_t hashesFingerprint{};
+    std::vector<Quest> quests;
+    std::vector<std::string> names;   // variable name table
+    std::vector<uint8_t> body;        // per-quest records
+};
+
+bool BuildQuestSnapshot(const QuestCatalog& catalog, QuestSnapshotImage& out, std::wstring* err);
+bool WriteQuestSnapshot(const std::filesystem::path& cacheDir, const QuestSnapshotImage& image, std::wstring* err);
+
+} // namespace arena2
@@ -0,0 +1,54 @@
+#include "pch.h"
+#include "TextArena.h"
+
+namespace arena2 {
+
+std::string_view TextArena::StoreLocked(std::string_view s) {
+    if (s.empty()) return {};
+    if (s.size() > m_left) {
+        // Oversized strings get a block of their own so the current block keeps its free tail.
+        if (s.size() > kBlockSize / 4) {
+            auto& block = m_blocks.emplace_back(std::make_unique_for_overwrite<char[]>(s.size()));
+            memcpy(block.get(), s.data(), s.size());
+            m_reserved += s.size();
+            m_used += s.size();
+            return { block.get(), s.size() };
+        }
+        auto& block = m_blocks.emplace_back(std::make_unique_for_overwrite<char[]>(kBlockSize));
+        m_cursor = block.get();
+        m_left = kBlockSize;
+        m_reserved += kBlockSize;
+    }
+    char* p = m_cursor;
+    memcpy(p, s.data(), s.size());
+    m_cursor += s.size();
+    m_left -= s.size();
+    m_used += s.size();
+    return { p, s.size() };
+}
+
+std::string_view TextArena::Store(std::string_view s) {
+    std::lock_guard lock(m_mutex);
+    return StoreLocked(s);
+}
+
+std::string_view TextArena::Intern(std::string_view s) {
+    std::lock_guard lock(m_mutex);
+    auto it = m_interned.find(s);
+    if (it != m_interned.end()) return *it;
+    const std::string_view stored = StoreLocked(s);
+    m_interned.insert(stored);
+    return stored;
+}
+
+TextArenaStats TextArena::Stats() const {
+    std::lock_guard lock(m_mutex);
+    TextArenaStats st;
+    st.blocks = m_blocks.size();
+    st.reservedBytes = m_reserved;
+    st.usedBytes = m_used;
+    st.internedStrings = m_interned.size();
+    return st;
+}
+
+} // namespace arena2
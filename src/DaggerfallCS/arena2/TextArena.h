@@ -0,0 +1,39 @@
+#pragma once
+#include "../pch.h"
+#include <memory>
+#include <mutex>
+
+namespace arena2 {
+
+struct TextArenaStats {
+    size_t blocks{};
+    size_t reservedBytes{};
+    size_t usedBytes{};
+    size_t internedStrings{};
+};
+
+// Append-only string storage shared by everything tokenized from one text database. Returned views stay valid
+// for the arena's lifetime; storing is thread-safe.
+class TextArena {
+public:
+    static constexpr size_t kBlockSize = 64u * 1024u;
+
+    std::string_view Store(std::string_view s);
+    // One copy per distinct string (variable names repeat across thousands of subrecords).
+    std::string_view Intern(std::string_view s);
+
+    TextArenaStats Stats() const;
+
+private:
+    std::string_view StoreLocked(std::string_view s);
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    char* m_cursor{};
+    size_t m_left{};
+    size_t m_reserved{};
+    size_t m_used{};
+    std::unordered_set<std::string_view> m_interned;
+};
+
+} // namespace arena2
@@ -31,34 +31,34 @@ void TextRecord::EnsureParsed(const std::vector<uint8_t>& fileBytes) {
 
     if (start >= fileBytes.size() || end > fileBytes.size() || end <= start) return;
 
-    std::vector<uint8_t> cur;
-    uint32_t p = start;
-
-    while (p < end) {
-        uint8_t b = fileBytes[p++];
-        if (b == 0xFF) {
-            TextSubrecord sr{};
-            sr.raw = std::move(cur);
-            sr.tokReady = false;
-            subrecords.push_back(std::move(sr));
-            cur = {};
-            continue;
-        }
-        if (b == 0xFE) {
-            TextSubrecord sr{};
-            sr.raw = std::move(cur);
-            sr.tokReady = false;
-            subrecords.push_back(std::move(sr));
-            return;
-        }
-        cur.push_back(b);
+    // 0xFF ends a subrecord, 0xFE ends the record; trailing bytes without a terminator form a last subrecord.
+    const uint8_t* data = fileBytes.data();
+    uint32_t stop = end;
+    uint32_t tail = start;
+    size_t count = 0;
+    for (uint32_t p = start; p < end; ++p) {
+        const uint8_t b = data[p];
+        if (b != 0xFF && b != 0xFE) continue;
+        count++;
+        tail = p + 1;
+        if (b == 0xFE) { stop = p + 1; break; }
     }
-
-    if (!cur.empty()) {
-        TextSubrecord sr{};
-        sr.raw = std::move(cur);
-        sr.tokReady = false;
-        subrecords.push_back(std::move(sr));
+    if (tail < stop) count++;
+    subrecords.reserve(count);
+
+    uint32_t segStart = start;
+    for (uint32_t p = start; p < stop; ++p) {
+        const uint8_t b = data[p];
+        if (b != 0xFF && b != 0xFE) continue;
+        TextSubrecord& sr = subrecords.emplace_back();
+        sr.raw = std::span<const uint8_t>(data + segStart, p - segStart);
+        sr.arena = arena;
+        segStart = p + 1;
+    }
+    if (segStart < stop) {
+        TextSubrecord& sr = subrecords.emplace_back();
+        sr.raw = std::span<const uint8_t>(data + segStart, stop - segStart);
+        sr.arena = arena;
     }
 }
 
@@ -165,17 +165,20 @@ static bool LoadTextDbFromBytes(std::vector<uint8_t> bytes, const std::filesyste
         return false;
     }
 
+    out.strings = std::make_shared<TextArena>();
     out.records.clear();
     out.records.reserve(headers.size());
     for (size_t i = 0; i < headers.size(); ++i) {
         TextRecord r{};
         r.recordId = headers[i].id;
+        r.arena = out.strings.get();
         r.start = headers[i].off;
         r.end = (i + 1 < headers.size()) ? headers[i + 1].off : termOff;
         if (r.end > (uint32_t)file.size()) r.end = (uint32_t)file.size();
         out.records.push_back(std::move(r));
     }
 
+    out.BuildIdIndex();
     return true;
 }
 
@@ -194,6 +197,10 @@ bool TextRsc::LoadFromFile(const std::filesystem::path& filePath, TextRsc& out,
     return LoadTextDbFromPath(filePath, out, err);
 }
 
+bool TextRsc::LoadFromBytes(std::vector<uint8_t> bytes, const std::filesystem::path& sourcePath, TextRsc& out, std::wstring* err) {
+    return LoadTextDbFromBytes(std::move(bytes), sourcePath, out, err);
+}
+
 static bool TryResolveTextRscPath(const std::filesystem::path& root, const std::vector<std::filesystem::path>& relCandidates,
                                   std::filesystem::path& outPath) {
     for (const auto& rel : relCandidates) {
@@ -227,6 +234,8 @@ bool TextRsc::LoadFromArena2Root(const std::filesystem::path& arena2Root, TextRs
 bool TextRsc::LoadFromBattlespireRoot(const std::filesystem::path& spireRoot, TextRsc& out, std::wstring* err) {
     out = {};
 
+    // Only two names in two folders matter here, so they are probed directly rather than listing the folders.
+    // Loose files in the root win over GameData, and TXT.BSA is only opened when no loose TEXT.RSC exists.
     std::filesystem::path candidate;
     if (TryResolveTextRscPath(spireRoot,
                                { std::filesystem::path("TEXT.RSC"), std::filesystem::path("GameData") / "TEXT.RSC" },
@@ -235,17 +244,17 @@ bool TextRsc::LoadFromBattlespireRoot(const std::filesystem::path& spireRoot, Te
     }
 
     // tools/bsatool is the source of truth for pre-Morrowind BSA footer layout and decompression.
-    std::filesystem::path txtBsa;
+    std::filesystem::path txtBsaPath;
     if (!TryResolveTextRscPath(spireRoot,
                                { std::filesystem::path("TXT.BSA"), std::filesystem::path("GameData") / "TXT.BSA" },
-                               txtBsa)) {
+                               txtBsaPath)) {
         if (err) *err = L"Could not find TEXT.RSC or TXT.BSA (expected in selected folder or GameData subfolder).";
         return false;
     }
 
     battlespire::BsaArchive archive;
     std::wstring aerr;
-    if (!battlespire::BsaArchive::LoadFromFile(txtBsa, archive, &aerr)) {
+    if (!battlespire::BsaArchive::LoadFromFile(txtBsaPath, archive, &aerr)) {
         if (err) {
             wchar_t buf[512]{};
             swprintf_s(buf, L"Failed to read TXT.BSA: %s", aerr.c_str());
@@ -253,7 +262,6 @@ bool TextRsc::LoadFromBattlespireRoot(const std::filesystem::path& spireRoot, Te
         }
         return false;
     }
-
     const auto* textEntry = archive.FindEntryCaseInsensitive("TEXT.RSC");
     if (!textEntry) {
         if (err) *err = L"TXT.BSA was loaded but TEXT.RSC entry was not found.";
@@ -271,19 +279,75 @@ bool TextRsc::LoadFromBattlespireRoot(const std::filesystem::path& spireRoot, Te
         return false;
     }
 
-    std::filesystem::path virtualSource = txtBsa;
+    std::filesystem::path virtualSource = txtBsaPath;
     virtualSource += L":TEXT.RSC";
     return LoadTextDbFromBytes(std::move(textBytes), virtualSource, out, err);
 }
 
+TextRsc::TextRsc(const TextRsc& other) {
+    *this = other;
+}
+
+TextRsc& TextRsc::operator=(const TextRsc& other) {
+    if (this == &other) return *this;
+    sourcePath = other.sourcePath;
+    fileBytes = other.fileBytes;
+    records = other.records;
+    strings = other.strings;
+    idSlots = other.idSlots;
+    idSorted = other.idSorted;
+
+    const uint8_t* oldBase = other.fileBytes.data();
+    for (auto& r : records) {
+        for (auto& sr : r.subrecords) {
+            if (sr.raw.empty()) continue;
+            sr.raw = std::span<const uint8_t>(fileBytes.data() + (sr.raw.data() - oldBase), sr.raw.size());
+            if (sr.tokReady) sr.tok.source = sr.raw;
+        }
+    }
+    return *this;
+}
+
+void TextRsc::BuildIdIndex() {
+    idSlots.clear();
+    idSorted.clear();
+    if (records.size() >= kDenseIdIndexMin) {
+        idSlots.assign(65536, 0);
+        for (size_t i = 0; i < records.size(); ++i) {
+            auto& slot = idSlots[records[i].recordId];
+            if (!slot) slot = static_cast<uint32_t>(i + 1);
+        }
+        return;
+    }
+
+    idSorted.reserve(records.size());
+    for (size_t i = 0; i < records.size(); ++i) idSorted.emplace_back(records[i].recordId, static_cast<uint32_t>(i));
+    // Pairs order by index within an id, so lower_bound lands on the first record of a duplicated id.
+    std::sort(idSorted.begin(), idSorted.end());
+}
+
+size_t TextRsc::IndexOf(uint16_t id) const {
+    if (!idSlots.empty()) {
+        const uint32_t slot = idSlots[id];
+        return slot ? size_t(slot - 1) : SIZE_MAX;
+    }
+    if (!idSorted.empty() || records.empty()) {
+        auto it = std::lower_bound(idSorted.begin(), idSorted.end(), std::make_pair(id, uint32_t(0)));
+        return (it != idSorted.end() && it->first == id) ? size_t(it->second) : SIZE_MAX;
+    }
+    // Records assembled without the loader: no index yet.
+    for (size_t i = 0; i < records.size(); ++i) if (records[i].recordId == id) return i;
+    return SIZE_MAX;
+}
+
 const TextRecord* TextRsc::Find(uint16_t id) const {
-    for (const auto& r : records) if (r.recordId == id) return &r;
-    return nullptr;
+    const size_t i = IndexOf(id);
+    return i == SIZE_MAX ? nullptr : &records[i];
 }
 
 TextRecord* TextRsc::FindMutable(uint16_t id) {
-    for (auto& r : records) if (r.recordId == id) return &r;
-    return nullptr;
+    const size_t i = IndexOf(id);
+    return i == SIZE_MAX ? nullptr : &records[i];
 }
 
 } // namespace arena2
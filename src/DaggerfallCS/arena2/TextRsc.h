@@ -5,18 +5,24 @@
 namespace arena2 {
 
 struct TextSubrecord {
-    std::vector<uint8_t> raw;
+    // View into the owning TextRsc::fileBytes (which stays resident); empty for subrecords added by the UI.
+    std::span<const uint8_t> raw;
+    // The owning TextRsc's string arena (null for subrecords added by the UI: tokens then get a private one).
+    TextArena* arena{};
 
-    // Non-persistent UI override (UTF-8). Used for TES4-compliant viewing/export without mutating source files.
+    // Non-persistent UI override (UTF-8 rich text, see EncodeTextSubrecord). Used for TES4-compliant viewing/export
+    // without mutating source files.
     std::string userOverride;
     bool hasUserOverride{ false };
+    std::string overridePlain;   // plain rendering of userOverride, built on first use
+    bool overridePlainReady{ false };
 
     TokenizedText tok{};
     bool tokReady{ false };
 
     inline TokenizedText& EnsureTokens() {
         if (!tokReady) {
-            tok = TokenizeTextSubrecord(raw);
+            tok = TokenizeTextSubrecord(raw, arena);
             tokReady = true;
         }
         return tok;
@@ -25,19 +31,33 @@ struct TextSubrecord {
     inline void ClearOverride() {
         userOverride.clear();
         hasUserOverride = false;
+        overridePlain.clear();
+        overridePlainReady = false;
     }
     inline void SetOverride(std::string v) {
         userOverride = std::move(v);
         hasUserOverride = true;
+        overridePlainReady = false;
+    }
+    // The override as the TEXT.RSC writer would encode it, rendered back to plain text (markup dropped).
+    inline std::string_view OverridePlain() {
+        if (!overridePlainReady) {
+            std::vector<uint8_t> bytes;
+            EncodeTextSubrecord(userOverride, bytes);
+            overridePlain.clear();
+            RenderPlain(bytes, overridePlain);
+            overridePlainReady = true;
+        }
+        return overridePlain;
     }
 
-    inline const std::string& EffectivePlain() {
+    inline std::string_view EffectivePlain() {
         auto& t = EnsureTokens();
-        return hasUserOverride ? userOverride : t.plain;
+        return hasUserOverride ? OverridePlain() : t.Plain();
     }
-    inline const std::string& EffectiveRich() {
+    inline std::string_view EffectiveRich() {
         auto& t = EnsureTokens();
-        return hasUserOverride ? userOverride : t.rich;
+        return hasUserOverride ? std::string_view(userOverride) : t.Rich();
     }
 };
 
@@ -46,14 +66,23 @@ struct TextRecord {
     uint16_t recordId{};
     uint32_t start{};
     uint32_t end{};
+    TextArena* arena{};   // handed to the subrecords; owned by the TextRsc
 
     std::vector<TextSubrecord> subrecords;
     bool parsed{ false };
 
+    // Splits [start, end) on 0xFF/0xFE into views of fileBytes, with one allocation for the subrecord list.
     void EnsureParsed(const std::vector<uint8_t>& fileBytes);
 };
 
 struct TextRsc {
+    TextRsc() = default;
+    TextRsc(TextRsc&&) noexcept = default;
+    TextRsc& operator=(TextRsc&&) noexcept = default;
+    // Copies re-point parsed subrecord views at their own fileBytes.
+    TextRsc(const TextRsc& other);
+    TextRsc& operator=(const TextRsc& other);
+
     std::filesystem::path sourcePath;
 
     // Keep bytes resident so records can be parsed lazily.
@@ -62,11 +91,25 @@ struct TextRsc {
     // Records are indexed at load-time; subrecords are parsed on demand.
     std::vector<TextRecord> records;
 
+    // Plain/rich text and variable names of every tokenized subrecord. Shared by copies, so token views stay valid.
+    std::shared_ptr<TextArena> strings;
+
+    // Record id -> index into records, built by the loader. Large databases (TEXT.RSC) use a dense table indexed
+    // by id (index + 1, 0 = absent); small ones (QRC files) a sorted (id, index) list. Duplicate ids keep the
+    // first record, matching the old linear scan.
+    static constexpr size_t kDenseIdIndexMin = 1024;
+    std::vector<uint32_t> idSlots;
+    std::vector<std::pair<uint16_t, uint32_t>> idSorted;
+
     static bool LoadFromFile(const std::filesystem::path& filePath, TextRsc& out, std::wstring* err);
+    // Parses an in-memory database; sourcePath is only recorded.
+    static bool LoadFromBytes(std::vector<uint8_t> bytes, const std::filesystem::path& sourcePath, TextRsc& out, std::wstring* err);
 
     static bool LoadFromArena2Root(const std::filesystem::path& arena2Root, TextRsc& out, std::wstring* err);
     static bool LoadFromBattlespireRoot(const std::filesystem::path& spireRoot, TextRsc& out, std::wstring* err);
 
+    void BuildIdIndex();
+    size_t IndexOf(uint16_t id) const;   // SIZE_MAX when absent
     const TextRecord* Find(uint16_t id) const;
     TextRecord* FindMutable(uint16_t id);
 };
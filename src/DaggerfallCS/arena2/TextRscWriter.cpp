@@ -0,0 +1,124 @@
+#include "pch.h"
+#include "TextRscWriter.h"
+
+namespace arena2 {
+
+static void PutU16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void PutU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static bool HasOverride(const TextRecord& rec) {
+    if (!rec.parsed) return false;
+    for (const auto& sr : rec.subrecords) if (sr.hasUserOverride) return true;
+    return false;
+}
+
+// Edited text keeps the line-break code the original subrecord used first.
+static TokenType LineBreakOf(std::span<const uint8_t> raw) {
+    TokenCursor cursor(raw);
+    Token tok;
+    while (cursor.Next(tok)) {
+        if (tok.type == TokenType::NewLine || tok.type == TokenType::EndOfLineLeft || tok.type == TokenType::EndOfLineCenter) return tok.type;
+    }
+    return TokenType::EndOfLineLeft;
+}
+
+static void EncodeRecord(const TextRecord& rec, std::vector<uint8_t>& out) {
+    for (size_t i = 0; i < rec.subrecords.size(); ++i) {
+        const auto& sr = rec.subrecords[i];
+        if (sr.hasUserOverride) EncodeTextSubrecord(sr.userOverride, out, LineBreakOf(sr.raw));
+        else out.insert(out.end(), sr.raw.begin(), sr.raw.end());
+        out.push_back(i + 1 < rec.subrecords.size() ? 0xFF : 0xFE);
+    }
+}
+
+bool WriteTextDatabase(const TextRsc& db, std::vector<uint8_t>& out, TextDbWriteResult* result, std::wstring* err) {
+    if (result) *result = {};
+    out.clear();
+
+    const size_t count = db.records.size();
+    if ((count + 1) * 6 > 0xFFFF) {
+        if (err) *err = L"Too many records for a text database header.";
+        return false;
+    }
+    const size_t headerLen = (count + 1) * 6;
+
+    // Untouched records are sized from their spans up front, so the output is allocated once when nothing is edited.
+    size_t copiedBytes = 0;
+    for (const auto& rec : db.records) {
+        if (!HasOverride(rec) && rec.end > rec.start && rec.end <= db.fileBytes.size()) copiedBytes += rec.end - rec.start;
+    }
+    out.reserve(2 + headerLen + copiedBytes);
+    out.resize(2 + headerLen);
+    PutU16(out.data(), static_cast<uint16_t>(headerLen));
+
+    size_t encoded = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const auto& rec = db.records[i];
+        uint8_t* slot = out.data() + 2 + i * 6;
+        PutU16(slot, rec.recordId);
+        PutU32(slot + 2, static_cast<uint32_t>(out.size()));
+
+        if (HasOverride(rec)) {
+            EncodeRecord(rec, out);
+            encoded++;
+        } else if (rec.end > rec.start && rec.end <= db.fileBytes.size()) {
+            out.insert(out.end(), db.fileBytes.begin() + rec.start, db.fileBytes.begin() + rec.end);
+        }
+    }
+
+    if (out.size() > 0xFFFFFFFFull) {
+        if (err) *err = L"Text database would exceed 4 GB.";
+        return false;
+    }
+    uint8_t* term = out.data() + 2 + count * 6;
+    PutU16(term, 0xFFFF);
+    PutU32(term + 2, static_cast<uint32_t>(out.size()));
+
+    if (result) {
+        result->records = count;
+        result->copiedRecords = count - encoded;
+        result->encodedRecords = encoded;
+        result->fileBytes = out.size();
+    }
+    return true;
+}
+
+bool WriteTextDatabaseFile(const TextRsc& db, const std::filesystem::path& outPath, TextDbWriteResult* result, std::wstring* err) {
+    std::vector<uint8_t> bytes;
+    if (!WriteTextDatabase(db, bytes, result, err)) return false;
+
+    std::filesystem::path tmp = outPath;
+    tmp += L".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            if (err) *err = L"Failed to create " + tmp.wstring();
+            return false;
+        }
+        f.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+        if (!f.good()) {
+            f.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+            if (err) *err = L"Failed to write " + tmp.wstring();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, outPath, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        if (err) *err = L"Failed to replace " + outPath.wstring();
+        return false;
+    }
+    return true;
+}
+
+} // namespace arena2
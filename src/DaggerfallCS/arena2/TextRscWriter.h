@@ -0,0 +1,23 @@
+#pragma once
+#include "../pch.h"
+#include "TextRsc.h"
+
+namespace arena2 {
+
+struct TextDbWriteResult {
+    size_t records{};
+    size_t copiedRecords{};     // written as the original byte span
+    size_t encodedRecords{};    // rebuilt because a subrecord carries an override
+    uint64_t fileBytes{};
+};
+
+// Serializes a text record database (TEXT.RSC or a QRC): u16 header length, one (u16 id, u32 offset) slot per
+// record, a 0xFFFF terminator slot holding the end offset, then the record bodies. Records without overridden
+// subrecords are copied from fileBytes as they are; the others are rebuilt subrecord by subrecord (0xFF between
+// subrecords, 0xFE at the end), encoding each override with EncodeTextSubrecord.
+bool WriteTextDatabase(const TextRsc& db, std::vector<uint8_t>& out, TextDbWriteResult* result, std::wstring* err);
+
+// Same, written to <outPath>.tmp and renamed over outPath on success.
+bool WriteTextDatabaseFile(const TextRsc& db, const std::filesystem::path& outPath, TextDbWriteResult* result, std::wstring* err);
+
+} // namespace arena2
@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "TextScan.h"
+#include <bit>
+#include <intrin.h>
+#include <immintrin.h>
+
+namespace arena2 {
+
+using ScanFn = size_t (*)(const uint8_t* p, size_t size, size_t i);
+
+static size_t ScanScalar(const uint8_t* p, size_t size, size_t i) {
+    for (; i < size; ++i) {
+        if (p[i] < 0x20 || p[i] > 0x7F) return i;
+        if (i + 3 < size && p[i + 1] == 0xFB) return i;
+    }
+    return size;
+}
+
+// Each block tests bytes i..i+15 and their successors, so it needs i + 17 bytes; requiring i + 19 also makes
+// every 0xFB successor in the block a complete position code (i + k + 3 < size), leaving the edge to the scalar tail.
+static size_t ScanSse2(const uint8_t* p, size_t size, size_t i) {
+    const __m128i low = _mm_set1_epi8(0x20);
+    const __m128i pos = _mm_set1_epi8(static_cast<char>(0xFB));
+    for (; i + 19 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1));
+        // Signed compare: 0x80..0xFF are negative, so one compare catches both < 0x20 and >= 0x80.
+        const __m128i stop = _mm_or_si128(_mm_cmplt_epi8(v, low), _mm_cmpeq_epi8(next, pos));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(stop));
+        if (mask) return i + std::countr_zero(mask);
+    }
+    return ScanScalar(p, size, i);
+}
+
+static size_t ScanAvx2(const uint8_t* p, size_t size, size_t i) {
+    const __m256i low = _mm256_set1_epi8(0x20);
+    const __m256i pos = _mm256_set1_epi8(static_cast<char>(0xFB));
+    for (; i + 35 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 1));
+        const __m256i stop = _mm256_or_si256(_mm256_cmpgt_epi8(low, v), _mm256_cmpeq_epi8(next, pos));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(stop));
+        if (mask) return i + std::countr_zero(mask);
+    }
+    return ScanSse2(p, size, i);
+}
+
+static bool CpuHasAvx2() {
+    int info[4]{};
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;   // OS must save XMM and YMM state
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+static TextScanMode ResolveMode(TextScanMode mode) {
+    static const bool hasAvx2 = CpuHasAvx2();
+    if (mode == TextScanMode::Auto) return hasAvx2 ? TextScanMode::Avx2 : TextScanMode::Sse2;
+    if (mode == TextScanMode::Avx2 && !hasAvx2) return TextScanMode::Sse2;
+    return mode;
+}
+
+static ScanFn FnForMode(TextScanMode mode) {
+    switch (mode) {
+    case TextScanMode::Scalar: return ScanScalar;
+    case TextScanMode::Avx2: return ScanAvx2;
+    default: return ScanSse2;
+    }
+}
+
+static std::atomic<TextScanMode>& ActiveMode() {
+    static std::atomic<TextScanMode> mode{ ResolveMode(TextScanMode::Auto) };
+    return mode;
+}
+
+static std::atomic<ScanFn>& ActiveFn() {
+    static std::atomic<ScanFn> fn{ FnForMode(ActiveMode().load()) };
+    return fn;
+}
+
+size_t FindTextRunEnd(std::span<const uint8_t> bytes, size_t from) {
+    if (from >= bytes.size()) return bytes.size();
+    return ActiveFn().load(std::memory_order_relaxed)(bytes.data(), bytes.size(), from);
+}
+
+void SetTextScanMode(TextScanMode mode) {
+    const TextScanMode resolved = ResolveMode(mode);
+    ActiveMode().store(resolved);
+    ActiveFn().store(FnForMode(resolved));
+}
+
+TextScanMode ActiveTextScanMode() {
+    return ActiveMode().load();
+}
+
+const wchar_t* TextScanModeName(TextScanMode mode) {
+    switch (mode) {
+    case TextScanMode::Scalar: return L"scalar";
+    case TextScanMode::Sse2: return L"SSE2";
+    case TextScanMode::Avx2: return L"AVX2";
+    default: return L"auto";
+    }
+}
+
+} // namespace arena2
@@ -0,0 +1,20 @@
+#pragma once
+#include "../pch.h"
+#include <span>
+
+namespace arena2 {
+
+// End of the printable text run starting at from: the first index >= from whose byte is outside 0x20..0x7F
+// or that starts a position code (next byte 0xFB and both argument bytes present). Returns bytes.size() if
+// the run reaches the end. Vectorized with SSE2, or AVX2 when the CPU supports it.
+size_t FindTextRunEnd(std::span<const uint8_t> bytes, size_t from);
+
+enum class TextScanMode : uint8_t { Auto, Scalar, Sse2, Avx2 };
+
+// Forces an implementation (verification and benchmarks); Auto picks the best one the CPU supports.
+// Requesting Avx2 on a CPU without it falls back to SSE2.
+void SetTextScanMode(TextScanMode mode);
+TextScanMode ActiveTextScanMode();
+const wchar_t* TextScanModeName(TextScanMode mode);
+
+} // namespace arena2
@@ -0,0 +1,176 @@
+#include "pch.h"
+#include "TextSearch.h"
+
+namespace arena2 {
+
+static inline uint8_t FoldByte(uint8_t c) {
+    if (c >= 'A' && c <= 'Z') return static_cast<uint8_t>(c + ('a' - 'A'));
+    if (c == '\n' || c == '\r' || c == '\f' || c == '\t') return ' ';
+    return c;
+}
+
+static std::string FoldText(std::string_view s) {
+    std::string out(s);
+    for (auto& c : out) c = static_cast<char>(FoldByte(static_cast<uint8_t>(c)));
+    return out;
+}
+
+void TextSearchIndex::CollectTrigrams(std::string_view text, std::vector<uint32_t>& out) {
+    out.clear();
+    if (text.size() < 3) return;
+    const auto* p = reinterpret_cast<const uint8_t*>(text.data());
+    uint32_t gram = (uint32_t(FoldByte(p[0])) << 8) | FoldByte(p[1]);
+    out.reserve(text.size() - 2);
+    for (size_t i = 2; i < text.size(); ++i) {
+        gram = ((gram << 8) | FoldByte(p[i])) & 0xFFFFFFu;
+        out.push_back(gram);
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void TextSearchIndex::AddDatabase(uint32_t source, TextRsc& db) {
+    std::string text;
+    for (auto& rec : db.records) {
+        rec.EnsureParsed(db.fileBytes);
+        for (size_t i = 0; i < rec.subrecords.size() && i <= 0xFFFF; ++i) {
+            auto& sr = rec.subrecords[i];
+            text.clear();
+            if (sr.hasUserOverride) text = sr.OverridePlain();
+            else if (sr.tokReady) RenderPlain(sr.tok, text);
+            else RenderPlain(sr.raw, text);
+            SetText(source, rec.recordId, static_cast<uint16_t>(i), text);
+        }
+    }
+}
+
+void TextSearchIndex::SetText(uint32_t source, uint16_t recordId, uint16_t subrecord, std::string_view text) {
+    std::vector<uint32_t> grams;
+    const uint64_t key = KeyOf(source, recordId, subrecord);
+    auto [it, inserted] = m_docByKey.try_emplace(key, static_cast<uint32_t>(m_docs.size()));
+    const uint32_t docId = it->second;
+
+    if (inserted) {
+        m_docs.push_back({ key, std::string(text) });
+        // New documents take the highest id, so their postings stay sorted by appending.
+        CollectTrigrams(text, grams);
+        for (uint32_t g : grams) m_postings[g].push_back(docId);
+        return;
+    }
+
+    Doc& doc = m_docs[docId];
+    if (doc.text == text) return;
+    CollectTrigrams(doc.text, grams);
+    for (uint32_t g : grams) {
+        auto pit = m_postings.find(g);
+        if (pit == m_postings.end()) continue;
+        auto& list = pit->second;
+        auto pos = std::lower_bound(list.begin(), list.end(), docId);
+        if (pos != list.end() && *pos == docId) list.erase(pos);
+        if (list.empty()) m_postings.erase(pit);
+    }
+    doc.text.assign(text);
+    CollectTrigrams(doc.text, grams);
+    for (uint32_t g : grams) {
+        auto& list = m_postings[g];
+        auto pos = std::lower_bound(list.begin(), list.end(), docId);
+        if (pos == list.end() || *pos != docId) list.insert(pos, docId);
+    }
+}
+
+void TextSearchIndex::Merge(TextSearchIndex&& other) {
+    constexpr uint32_t kSkipped = UINT32_MAX;
+    std::vector<uint32_t> remap(other.m_docs.size(), kSkipped);
+    m_docs.reserve(m_docs.size() + other.m_docs.size());
+    for (uint32_t d = 0; d < other.m_docs.size(); ++d) {
+        auto [it, inserted] = m_docByKey.try_emplace(other.m_docs[d].key, static_cast<uint32_t>(m_docs.size()));
+        if (!inserted) continue;
+        remap[d] = it->second;
+        m_docs.push_back(std::move(other.m_docs[d]));
+    }
+    // Merged documents take the highest ids in their original order, so their postings stay sorted by appending.
+    for (const auto& [g, list] : other.m_postings) {
+        auto& dst = m_postings[g];
+        for (uint32_t d : list) {
+            if (remap[d] != kSkipped) dst.push_back(remap[d]);
+        }
+        if (dst.empty()) m_postings.erase(g);
+    }
+    other = {};
+}
+
+void TextSearchIndex::FindInDoc(uint32_t docId, std::string_view folded, size_t maxHits, std::vector<TextSearchHit>& out) const {
+    const Doc& doc = m_docs[docId];
+    const auto* t = reinterpret_cast<const uint8_t*>(doc.text.data());
+    const auto* q = reinterpret_cast<const uint8_t*>(folded.data());
+    const size_t n = doc.text.size(), m = folded.size();
+    for (size_t i = 0; i + m <= n && out.size() < maxHits; ++i) {
+        size_t k = 0;
+        while (k < m && FoldByte(t[i + k]) == q[k]) ++k;
+        if (k != m) continue;
+        TextSearchHit hit;
+        hit.source = static_cast<uint32_t>(doc.key >> 32);
+        hit.recordId = static_cast<uint16_t>(doc.key >> 16);
+        hit.subrecord = static_cast<uint16_t>(doc.key);
+        hit.offset = static_cast<uint32_t>(i);
+        out.push_back(hit);
+    }
+}
+
+std::vector<TextSearchHit> TextSearchIndex::Find(std::string_view query, size_t maxHits) const {
+    std::vector<TextSearchHit> hits;
+    if (query.empty() || maxHits == 0) return hits;
+    const std::string folded = FoldText(query);
+
+    if (folded.size() < 3) {
+        for (uint32_t d = 0; d < m_docs.size() && hits.size() < maxHits; ++d) FindInDoc(d, folded, maxHits, hits);
+        return hits;
+    }
+
+    std::vector<uint32_t> grams;
+    CollectTrigrams(folded, grams);
+    std::vector<const std::vector<uint32_t>*> lists;
+    lists.reserve(grams.size());
+    for (uint32_t g : grams) {
+        auto it = m_postings.find(g);
+        if (it == m_postings.end()) return hits;
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+    // Intersect starting from the rarest trigram; the candidate list only shrinks.
+    std::vector<uint32_t> candidates = *lists[0];
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        const auto& list = *lists[i];
+        auto from = list.begin();
+        size_t kept = 0;
+        for (uint32_t d : candidates) {
+            from = std::lower_bound(from, list.end(), d);
+            if (from == list.end()) break;
+            if (*from == d) candidates[kept++] = d;
+        }
+        candidates.resize(kept);
+    }
+
+    for (uint32_t d : candidates) {
+        if (hits.size() >= maxHits) break;
+        FindInDoc(d, folded, maxHits, hits);
+    }
+    return hits;
+}
+
+std::string_view TextSearchIndex::TextOf(const TextSearchHit& hit) const {
+    auto it = m_docByKey.find(KeyOf(hit.source, hit.recordId, hit.subrecord));
+    return it == m_docByKey.end() ? std::string_view() : std::string_view(m_docs[it->second].text);
+}
+
+TextSearchStats TextSearchIndex::Stats() const {
+    TextSearchStats s;
+    s.documents = m_docs.size();
+    s.trigrams = m_postings.size();
+    for (const auto& [g, list] : m_postings) s.postings += list.size();
+    for (const auto& d : m_docs) s.textBytes += d.text.size();
+    return s;
+}
+
+} // namespace arena2
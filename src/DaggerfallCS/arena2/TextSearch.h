@@ -0,0 +1,62 @@
+#pragma once
+#include "../pch.h"
+#include "TextRsc.h"
+
+namespace arena2 {
+
+struct TextSearchHit {
+    uint32_t source{};       // TextSearchIndex::kTextRsc, or quest index + 1 for that quest's QRC
+    uint16_t recordId{};
+    uint16_t subrecord{};
+    uint32_t offset{};       // byte offset of the match in the subrecord's plain text
+};
+
+struct TextSearchStats {
+    size_t documents{};
+    size_t trigrams{};
+    size_t postings{};
+    uint64_t textBytes{};
+};
+
+// Case-insensitive substring search over the plain text of every indexed subrecord. Each subrecord is a
+// document; a trigram -> sorted document list index narrows a query to the documents containing all of its
+// trigrams, which are then verified. Folding is ASCII-only and treats line/page breaks and tabs as spaces,
+// so a query can match across a line break.
+class TextSearchIndex {
+public:
+    static constexpr uint32_t kTextRsc = 0;
+
+    // Indexes every subrecord of db (parsing records as needed), using overrides where set.
+    void AddDatabase(uint32_t source, TextRsc& db);
+    // Adds or replaces one subrecord's text; postings are updated in place.
+    void SetText(uint32_t source, uint16_t recordId, uint16_t subrecord, std::string_view text);
+    // Moves in the documents of an index built separately (e.g. on a worker thread) without re-collecting
+    // trigrams. Subrecords already indexed here keep their current text.
+    void Merge(TextSearchIndex&& other);
+
+    // Hits in index order (the order databases were added), every occurrence in each subrecord.
+    // Queries shorter than three characters scan all documents.
+    std::vector<TextSearchHit> Find(std::string_view query, size_t maxHits) const;
+    // Plain text of the hit's subrecord (empty if it is not indexed).
+    std::string_view TextOf(const TextSearchHit& hit) const;
+
+    TextSearchStats Stats() const;
+
+private:
+    struct Doc {
+        uint64_t key{};
+        std::string text;
+    };
+
+    static uint64_t KeyOf(uint32_t source, uint16_t recordId, uint16_t subrecord) {
+        return (uint64_t(source) << 32) | (uint32_t(recordId) << 16) | subrecord;
+    }
+    static void CollectTrigrams(std::string_view text, std::vector<uint32_t>& out);
+    void FindInDoc(uint32_t docId, std::string_view folded, size_t maxHits, std::vector<TextSearchHit>& out) const;
+
+    std::vector<Doc> m_docs;
+    std::unordered_map<uint64_t, uint32_t> m_docByKey;
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_postings;
+};
+
+} // namespace arena2
@@ -1,254 +1,379 @@
 #include "pch.h"
 #include "TextTokens.h"
 #include "VarHashCatalog.h"
+#include "TextScan.h"
+#include <charconv>
 
 namespace arena2 {
 
-static void AppendPlain(TokenizedText& t, std::string_view s) { t.plain.append(s); }
-static void AppendRich(TokenizedText& t, std::string_view s) { t.rich.append(s); }
-
 static bool IsVarChar(unsigned char c) {
     return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
 }
 
-static std::string ToLowerAscii(std::string_view s) {
-    std::string out(s);
-    for (auto& c : out) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
-    return out;
-}
+bool TokenCursor::Next(Token& tok) {
+    const auto& bytes = m_bytes;
+    const size_t i = m_pos;
+    m_varPos = m_varEnd = 0;
+    if (i >= bytes.size()) return false;
+
+    tok = {};
+    tok.byteOffset = static_cast<uint32_t>(i);
+    const uint8_t b = bytes[i];
+
+    // PositionCode: (NewLineOffset/SameLineOffset/PullPreceeding) 0xFB X Y
+    // Note: "greedy" parsing means values like 0xFC 0xFB ... are PositionCode, not EndOfLineLeft.
+    if ((i + 3) < bytes.size() && bytes[i + 1] == 0xFB) {
+        tok.type = TokenType::Position;
+        tok.arg0 = b;   // 0x00 new line offset, 0x01 same line offset, 0x02-0xFF pull preceding
+        tok.arg1 = static_cast<uint16_t>(bytes[i + 2] | (uint32_t(bytes[i + 3]) << 8));
+        if (b == 0x00) m_plainLength += 1;
+        m_pos = i + 4;
+        return true;
+    }
 
-static void DetectVarsInText(TokenizedText& t, std::string_view text, size_t plainBase, size_t byteBase) {
-    // %name
-    for (size_t i = 0; i < text.size(); ++i) {
-        unsigned char c = (unsigned char)text[i];
-        if (c == '%') {
-            size_t j = i + 1;
-            if (j >= text.size()) continue;
-            if (!IsVarChar((unsigned char)text[j])) continue;
-
-            while (j < text.size() && IsVarChar((unsigned char)text[j])) j++;
-
-            std::string name = ToLowerAscii(text.substr(i + 1, j - (i + 1)));
-            if (name.empty()) continue;
-
-            VarRef vr{};
-            vr.style = VarStyle::Percent;
-            vr.token = std::string(text.substr(i, j - i));
-            vr.name = name;
-            vr.hash = ComputeVarHash(name);
-            vr.plainOffset = plainBase + i;
-            vr.byteOffset = byteBase + i;
-            t.vars.push_back(std::move(vr));
-            i = j - 1;
-            continue;
-        }
+    // EndOfLine codes: 0xFC 0x00 or 0xFD 0x00
+    if ((b == 0xFC || b == 0xFD) && (i + 1 < bytes.size()) && bytes[i + 1] == 0x00) {
+        tok.type = (b == 0xFC) ? TokenType::EndOfLineLeft : TokenType::EndOfLineCenter;
+        m_plainLength += 1;
+        m_pos = i + 2;
+        return true;
+    }
 
-        // _name_ (leading underscore, trailing underscore)
-        if (c == '_') {
-            size_t j = i + 1;
-            if (j >= text.size()) continue;
-            if (!IsVarChar((unsigned char)text[j])) continue;
-
-            while (j < text.size() && IsVarChar((unsigned char)text[j])) j++;
-            if (j >= text.size()) continue;
-            if (text[j] != '_') continue;
-
-            std::string name = ToLowerAscii(text.substr(i + 1, j - (i + 1)));
-            if (name.empty()) continue;
-
-            VarRef vr{};
-            vr.style = VarStyle::Underscore;
-            vr.token = std::string(text.substr(i, (j + 1) - i));
-            vr.name = name;
-            vr.hash = ComputeVarHash(name);
-            vr.plainOffset = plainBase + i;
-            vr.byteOffset = byteBase + i;
-            t.vars.push_back(std::move(vr));
-
-            i = j; // will increment to j+1
-            continue;
-        }
+    // NewLine token
+    if (b == 0x00) {
+        tok.type = TokenType::NewLine;
+        m_plainLength += 1;
+        m_pos = i + 1;
+        return true;
+    }
+
+    // EndOfPage
+    if (b == 0xF6) {
+        tok.type = TokenType::EndOfPage;
+        m_plainLength += 3;
+        m_pos = i + 1;
+        return true;
+    }
+
+    // FontPrefix (0xF9) + font byte, FontColor (0xFA) + color index
+    if ((b == 0xF9 || b == 0xFA) && (i + 1 < bytes.size())) {
+        tok.type = (b == 0xF9) ? TokenType::Font : TokenType::Color;
+        tok.arg0 = bytes[i + 1];
+        m_pos = i + 2;
+        return true;
+    }
+
+    // BookImage: 0xF7 + zero-terminated IMG name
+    if (b == 0xF7) {
+        size_t j = i + 1;
+        while (j < bytes.size() && bytes[j] != 0x00 && j - (i + 1) < 255) j++;
+        tok.type = TokenType::BookImage;
+        tok.textLength = static_cast<uint32_t>(j - (i + 1));
+        m_pos = (j < bytes.size()) ? j + 1 : bytes.size();
+        return true;
+    }
+
+    // Printable ASCII: the whole run up to the next control byte or position code.
+    if (b >= 0x20 && b <= 0x7F) {
+        const size_t end = FindTextRunEnd(bytes, i + 1);
+        tok.type = TokenType::Text;
+        tok.textLength = static_cast<uint32_t>(end - i);
+        m_varBegin = m_varPos = i;
+        m_varEnd = end;
+        m_varPlainBase = m_plainLength;
+        m_plainLength += end - i;
+        m_pos = end;
+        return true;
     }
+
+    tok.type = TokenType::Unknown;
+    tok.arg0 = b;
+    m_pos = i + 1;
+    return true;
 }
 
-static void PushText(TokenizedText& t, std::string_view s, size_t byteOffsetStart) {
-    if (s.empty()) return;
+// %name, or _name_ (leading and trailing underscore).
+bool TokenCursor::NextVar(VarRef& var) {
+    const char* text = reinterpret_cast<const char*>(m_bytes.data());
+    for (size_t i = m_varPos; i < m_varEnd; ++i) {
+        const unsigned char c = (unsigned char)text[i];
+        if (c != '%' && c != '_') continue;
 
-    size_t plainBase = t.plain.size();
+        size_t j = i + 1;
+        if (j >= m_varEnd) continue;
+        if (!IsVarChar((unsigned char)text[j])) continue;
+        while (j < m_varEnd && IsVarChar((unsigned char)text[j])) j++;
 
-    Token tok{};
-    tok.type = TokenType::Text;
-    tok.text = std::string(s);
-    tok.byteOffset = byteOffsetStart;
-    t.tokens.push_back(tok);
+        size_t tokenEnd = j;
+        if (c == '_') {
+            if (j >= m_varEnd || text[j] != '_') continue;
+            tokenEnd = j + 1;
+        }
 
-    AppendPlain(t, s);
-    AppendRich(t, s);
+        std::string_view name(text + i + 1, j - (i + 1));
+        bool hasUpper = false;
+        for (char ch : name) if (ch >= 'A' && ch <= 'Z') { hasUpper = true; break; }
+        if (hasUpper) {
+            m_name.assign(name);
+            for (auto& ch : m_name) if (ch >= 'A' && ch <= 'Z') ch = (char)(ch - 'A' + 'a');
+            name = m_name;
+        }
 
-    DetectVarsInText(t, s, plainBase, byteOffsetStart);
+        var = {};
+        var.style = (c == '%') ? VarStyle::Percent : VarStyle::Underscore;
+        var.name = name;
+        var.hash = ComputeVarHash(name);
+        var.plainOffset = static_cast<uint32_t>(m_varPlainBase + (i - m_varBegin));
+        var.byteOffset = static_cast<uint32_t>(i);
+        var.tokenLength = static_cast<uint32_t>(tokenEnd - i);
+        m_varPos = tokenEnd;
+        return true;
+    }
+    m_varPos = m_varEnd;
+    return false;
 }
 
-static void PushSimple(TokenizedText& t, TokenType type, uint32_t a0, uint32_t a1, size_t off) {
-    Token tok{};
-    tok.type = type;
-    tok.arg0 = a0;
-    tok.arg1 = a1;
-    tok.byteOffset = off;
-    t.tokens.push_back(std::move(tok));
+// Builds into per-thread scratch vectors and copies out exact-size ones, so a subrecord costs a handful of
+// allocations however many tokens it has.
+struct TokenizeScratch {
+    std::vector<Token> tokens;
+    std::vector<VarRef> vars;
+};
+
+TokenizedText TokenizeTextSubrecord(std::span<const uint8_t> bytes, TextArena* arena) {
+    TokenizedText out{};
+    out.source = bytes;
+    if (!arena) {
+        out.ownedArena = std::make_shared<TextArena>();
+        arena = out.ownedArena.get();
+    }
+    out.arena = arena;
+
+    thread_local TokenizeScratch t;
+    t.tokens.clear();
+    t.vars.clear();
+
+    TokenCursor cursor(bytes);
+    Token tok;
+    VarRef var;
+    while (cursor.Next(tok)) {
+        t.tokens.push_back(tok);
+        if (tok.type == TokenType::Text) {
+            while (cursor.NextVar(var)) {
+                var.name = arena->Intern(var.name);
+                t.vars.push_back(var);
+            }
+        } else if (tok.type == TokenType::EndOfPage) {
+            out.hasEndOfPage = true;
+        } else if (tok.type == TokenType::Font && tok.arg0 == 0x02) {
+            out.hasFontScript = true;
+        }
+    }
+
+    out.tokens.assign(t.tokens.begin(), t.tokens.end());
+    out.vars.assign(t.vars.begin(), t.vars.end());
+    out.plainLength = static_cast<uint32_t>(cursor.PlainLength());
+    return out;
 }
 
-static std::string HexByte(uint8_t b) {
+static void AppendHexByte(std::string& out, uint8_t b) {
     static const char* hexd = "0123456789ABCDEF";
-    std::string s;
-    s.push_back(hexd[(b >> 4) & 0xF]);
-    s.push_back(hexd[b & 0xF]);
-    return s;
+    out.push_back(hexd[(b >> 4) & 0xF]);
+    out.push_back(hexd[b & 0xF]);
 }
 
-TokenizedText TokenizeTextSubrecord(const std::vector<uint8_t>& bytes) {
-    TokenizedText out{};
-    std::string run;
-    run.reserve(bytes.size());
+static void AppendUnsigned(std::string& out, unsigned v) {
+    char buf[12];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, end);
+}
 
-    size_t runStart = 0;
-    bool runActive = false;
+static void AppendPlain(const Token& tok, std::string_view text, std::string& out) {
+    switch (tok.type) {
+    case TokenType::Text: out.append(text); break;
+    // Best-effort plain reconstruction: PositionCode with NewLineOffset implies a newline.
+    case TokenType::Position: if (tok.arg0 == 0x00) out.push_back('\n'); break;
+    case TokenType::NewLine:
+    case TokenType::EndOfLineLeft:
+    case TokenType::EndOfLineCenter: out.push_back('\n'); break;
+    case TokenType::EndOfPage: out.append("\n\f\n"); break;
+    default: break;
+    }
+}
 
-    auto flushRun = [&](size_t curOff) {
-        (void)curOff;
-        if (!run.empty() && runActive) {
-            PushText(out, run, runStart);
-        }
-        run.clear();
-        runActive = false;
-    };
-
-    for (size_t i = 0; i < bytes.size(); ++i) {
-        uint8_t b = bytes[i];
-
-        // PositionCode: (NewLineOffset/SameLineOffset/PullPreceeding) 0xFB X Y
-        // Note: "greedy" parsing means values like 0xFC 0xFB ... are PositionCode, not EndOfLineLeft.
-        if ((i + 3) < bytes.size() && bytes[i + 1] == 0xFB) {
-            uint8_t mode = bytes[i];       // 0x00 new line offset, 0x01 same line offset, 0x02-0xFF pull preceding
-            uint8_t x = bytes[i + 2];
-            uint8_t y = bytes[i + 3];
-            flushRun(i);
-            PushSimple(out, TokenType::Position, mode, (uint32_t)(x | (uint32_t(y) << 8)), i);
-
-            // Best-effort plain reconstruction: PositionCode with NewLineOffset implies a newline.
-            if (mode == 0x00) out.plain.push_back('\n');
-
-            out.rich.append("<pos m=0x");
-            out.rich.append(HexByte(mode));
-            out.rich.append(" x=");
-            out.rich.append(std::to_string((unsigned)x));
-            out.rich.append(" y=");
-            out.rich.append(std::to_string((unsigned)y));
-            out.rich.append(">");
-
-            i += 3;
-            continue;
-        }
+void RenderPlain(const TokenizedText& t, std::string& out) {
+    out.reserve(out.size() + t.plainLength);
+    for (const auto& tok : t.tokens) AppendPlain(tok, t.TextOf(tok), out);
+}
 
-        // EndOfLine codes: 0xFC 0x00 or 0xFD 0x00
-        if ((b == 0xFC || b == 0xFD) && (i + 1 < bytes.size()) && bytes[i + 1] == 0x00) {
-            flushRun(i);
-            if (b == 0xFC) PushSimple(out, TokenType::EndOfLineLeft, 0, 0, i);
-            else PushSimple(out, TokenType::EndOfLineCenter, 0, 0, i);
+void RenderPlain(std::span<const uint8_t> bytes, std::string& out) {
+    TokenCursor cursor(bytes);
+    Token tok;
+    while (cursor.Next(tok)) AppendPlain(tok, cursor.TextOf(tok), out);
+}
 
-            out.plain.push_back('\n');
-            out.rich.append("\n");
-            i += 1;
-            continue;
+void RenderRich(const TokenizedText& t, std::string& out) {
+    out.reserve(out.size() + t.plainLength + t.tokens.size() * 4);
+    for (const auto& tok : t.tokens) {
+        switch (tok.type) {
+        case TokenType::Text: out.append(t.TextOf(tok)); break;
+        case TokenType::Position:
+            out.append("<pos m=0x");
+            AppendHexByte(out, tok.arg0);
+            out.append(" x=");
+            AppendUnsigned(out, tok.arg1 & 0xFFu);
+            out.append(" y=");
+            AppendUnsigned(out, tok.arg1 >> 8);
+            out.push_back('>');
+            break;
+        case TokenType::NewLine:
+        case TokenType::EndOfLineLeft:
+        case TokenType::EndOfLineCenter: out.push_back('\n'); break;
+        case TokenType::EndOfPage: out.append("\n<page/>\n"); break;
+        case TokenType::Font:
+            if (tok.arg0 == 0x02) out.append("<font=script>");
+            else if (tok.arg0 == 0x04) out.append("<font=normal>");
+            else {
+                out.append("<font=0x");
+                AppendHexByte(out, tok.arg0);
+                out.push_back('>');
+            }
+            break;
+        case TokenType::Color:
+            out.append("<color=");
+            AppendUnsigned(out, tok.arg0);
+            out.push_back('>');
+            break;
+        case TokenType::BookImage:
+            out.append("<bookimg=");
+            out.append(t.TextOf(tok));
+            out.push_back('>');
+            break;
+        case TokenType::Unknown:
+            out.append("<0x");
+            AppendHexByte(out, tok.arg0);
+            out.push_back('>');
+            break;
         }
+    }
+}
 
-        // NewLine token
-        if (b == 0x00) {
-            flushRun(i);
-            PushSimple(out, TokenType::NewLine, 0, 0, i);
-            out.plain.push_back('\n');
-            out.rich.append("\n");
-            continue;
-        }
+static bool IsRecordSeparator(uint8_t b) { return b == 0xFF || b == 0xFE; }
 
-        // EndOfPage
-        if (b == 0xF6) {
-            flushRun(i);
-            PushSimple(out, TokenType::EndOfPage, 0, 0, i);
-            out.hasEndOfPage = true;
-            out.plain.append("\n\f\n");
-            out.rich.append("\n<page/>\n");
-            continue;
-        }
+static bool ParseHexByte(std::string_view s, uint8_t& v) {
+    if (s.size() != 4 || s[0] != '0' || s[1] != 'x') return false;
+    unsigned x = 0;
+    auto [p, ec] = std::from_chars(s.data() + 2, s.data() + 4, x, 16);
+    if (ec != std::errc() || p != s.data() + 4) return false;
+    v = static_cast<uint8_t>(x);
+    return true;
+}
 
-        // FontPrefix (0xF9) + font byte
-        if (b == 0xF9 && (i + 1 < bytes.size())) {
-            uint8_t font = bytes[i + 1];
-            flushRun(i);
-            PushSimple(out, TokenType::Font, font, 0, i);
-            if (font == 0x02) out.hasFontScript = true;
+static bool ParseDecByte(std::string_view s, uint8_t& v) {
+    unsigned x = 0;
+    auto [p, ec] = std::from_chars(s.data(), s.data() + s.size(), x, 10);
+    if (ec != std::errc() || p != s.data() + s.size() || x > 0xFF) return false;
+    v = static_cast<uint8_t>(x);
+    return true;
+}
 
-            if (font == 0x02) out.rich.append("<font=script>");
-            else if (font == 0x04) out.rich.append("<font=normal>");
-            else {
-                out.rich.append("<font=0x");
-                out.rich.append(HexByte(font));
-                out.rich.append(">");
-            }
-            i += 1;
-            continue;
-        }
+// Bytes for one tag as RenderRich writes it (without the angle brackets). Tags whose bytes would contain a
+// subrecord separator are rejected and end up as literal text.
+static bool EncodeRichTag(std::string_view tag, std::vector<uint8_t>& out) {
+    uint8_t a = 0, x = 0, y = 0;
+    if (tag.starts_with("pos m=")) {
+        tag.remove_prefix(6);
+        const size_t xs = tag.find(" x="), ys = tag.find(" y=");
+        if (xs == std::string_view::npos || ys == std::string_view::npos || ys < xs) return false;
+        if (!ParseHexByte(tag.substr(0, xs), a) || !ParseDecByte(tag.substr(xs + 3, ys - xs - 3), x) || !ParseDecByte(tag.substr(ys + 3), y)) return false;
+        if (IsRecordSeparator(a) || IsRecordSeparator(x) || IsRecordSeparator(y)) return false;
+        out.insert(out.end(), { a, uint8_t(0xFB), x, y });
+        return true;
+    }
+    if (tag == "page/") { out.push_back(0xF6); return true; }
+    if (tag == "font=script") { out.insert(out.end(), { uint8_t(0xF9), uint8_t(0x02) }); return true; }
+    if (tag == "font=normal") { out.insert(out.end(), { uint8_t(0xF9), uint8_t(0x04) }); return true; }
+    if (tag.starts_with("font=")) {
+        if (!ParseHexByte(tag.substr(5), a) || IsRecordSeparator(a)) return false;
+        out.insert(out.end(), { uint8_t(0xF9), a });
+        return true;
+    }
+    if (tag.starts_with("color=")) {
+        if (!ParseDecByte(tag.substr(6), a) || IsRecordSeparator(a)) return false;
+        out.insert(out.end(), { uint8_t(0xFA), a });
+        return true;
+    }
+    if (tag.starts_with("bookimg=")) {
+        const std::string_view name = tag.substr(8);
+        if (name.size() > 255) return false;
+        for (char c : name) if (c == 0 || IsRecordSeparator(static_cast<uint8_t>(c))) return false;
+        out.push_back(0xF7);
+        out.insert(out.end(), name.begin(), name.end());
+        out.push_back(0x00);
+        return true;
+    }
+    if (ParseHexByte(tag, a) && !IsRecordSeparator(a)) {
+        out.push_back(a);
+        return true;
+    }
+    return false;
+}
 
-        // FontColor (0xFA) + color index
-        if (b == 0xFA && (i + 1 < bytes.size())) {
-            uint8_t color = bytes[i + 1];
-            flushRun(i);
-            PushSimple(out, TokenType::Color, color, 0, i);
-            out.rich.append("<color=");
-            out.rich.append(std::to_string((unsigned)color));
-            out.rich.append(">");
-            i += 1;
+void EncodeTextSubrecord(std::string_view rich, std::vector<uint8_t>& out, TokenType lineBreak) {
+    const size_t n = rich.size();
+    for (size_t i = 0; i < n;) {
+        const unsigned char c = static_cast<unsigned char>(rich[i]);
+        if (c == '\n') {
+            // "\n<page/>\n" is a single page break.
+            if (rich.substr(i + 1).starts_with("<page/>")) { ++i; continue; }
+            if (lineBreak == TokenType::NewLine) out.push_back(0x00);
+            else out.insert(out.end(), { uint8_t(lineBreak == TokenType::EndOfLineCenter ? 0xFD : 0xFC), uint8_t(0x00) });
+            ++i;
             continue;
         }
-
-        // BookImage: 0xF7 + zero-terminated IMG name
-        if (b == 0xF7) {
-            flushRun(i);
-            std::string name;
-            size_t j = i + 1;
-            while (j < bytes.size() && bytes[j] != 0x00 && name.size() < 255) {
-                name.push_back((char)bytes[j]);
-                j++;
+        if (c == '<') {
+            const size_t close = rich.find('>', i + 1);
+            if (close != std::string_view::npos && EncodeRichTag(rich.substr(i + 1, close - i - 1), out)) {
+                const bool page = rich.substr(i + 1, close - i - 1) == "page/";
+                i = close + 1;
+                if (page && i < n && rich[i] == '\n') ++i;
+                continue;
             }
-            Token tok{};
-            tok.type = TokenType::BookImage;
-            tok.text = name;
-            tok.byteOffset = i;
-            out.tokens.push_back(std::move(tok));
-            out.rich.append("<bookimg=");
-            out.rich.append(name);
-            out.rich.append(">");
-            i = (j < bytes.size()) ? j : (bytes.size() - 1);
+            out.push_back('<');
+            ++i;
             continue;
         }
+        if (c >= 0x20 && c <= 0x7F) { out.push_back(c); ++i; continue; }
+        if (c == '\t') { out.push_back(' '); ++i; continue; }
+        if (c < 0x80) { ++i; continue; }   // other control characters have no encoding
+
+        // The game fonts have no glyphs outside ASCII: one '?' per UTF-8 sequence.
+        out.push_back('?');
+        ++i;
+        while (i < n && (static_cast<unsigned char>(rich[i]) & 0xC0) == 0x80) ++i;
+    }
+}
 
-        // Printable ASCII: accumulate
-        if (b >= 0x20 && b <= 0x7F) {
-            if (!runActive) {
-                runActive = true;
-                runStart = i;
-            }
-            run.push_back((char)b);
-        } else {
-            flushRun(i);
-            PushSimple(out, TokenType::Unknown, b, 0, i);
-            out.rich.append("<0x");
-            out.rich.append(HexByte(b));
-            out.rich.append(">");
-        }
+std::string_view TokenizedText::Plain() {
+    if (!plainReady) {
+        thread_local std::string buf;
+        buf.clear();
+        RenderPlain(*this, buf);
+        plainCache = arena ? arena->Store(buf) : std::string_view{};
+        plainReady = true;
     }
+    return plainCache;
+}
 
-    flushRun(bytes.size());
-    return out;
+std::string_view TokenizedText::Rich() {
+    if (!richReady) {
+        thread_local std::string buf;
+        buf.clear();
+        RenderRich(*this, buf);
+        richCache = arena ? arena->Store(buf) : std::string_view{};
+        richReady = true;
+    }
+    return richCache;
 }
 
 } // namespace arena2
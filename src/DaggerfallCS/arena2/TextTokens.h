@@ -1,5 +1,7 @@
 #pragma once
 #include "../pch.h"
+#include "TextArena.h"
+#include <span>
 
 namespace arena2 {
 
@@ -16,34 +18,103 @@ enum class TokenType : uint8_t {
     Unknown
 };
 
+// Packed: text is not copied but referenced as bytes of the tokenized source (see TokenizedText::TextOf).
 struct Token {
     TokenType type{};
-    uint32_t  arg0{};
-    uint32_t  arg1{};
-    std::string text; // for TokenType::Text or BookImage name
-    size_t byteOffset{};
+    uint8_t   arg0{};       // position mode, font, color or the unknown byte
+    uint16_t  arg1{};       // position: x | (y << 8)
+    uint32_t  byteOffset{}; // offset in raw subrecord bytes
+    uint32_t  textLength{}; // TokenType::Text run or BookImage name length
 };
 
 enum class VarStyle : uint8_t { Percent, Underscore };
 
 struct VarRef {
     VarStyle style{};
-    std::string token;   // e.g. %npc or _npc_
-    std::string name;    // e.g. npc
-    uint32_t hash{};     // shift-add hash
-    size_t plainOffset{}; // offset in TokenizedText.plain
-    size_t byteOffset{};  // offset in raw subrecord bytes
+    uint32_t hash{};        // shift-add hash
+    uint32_t plainOffset{}; // offset in the plain rendering
+    uint32_t byteOffset{};  // offset in raw subrecord bytes; the token (e.g. %npc or _npc_) starts here
+    uint32_t tokenLength{};
+    std::string_view name;  // e.g. npc, lower-cased and interned in the arena
 };
 
+// Pull-style tokenizer over a subrecord's bytes: yields the tokens (and, after each Text token, its variables) of
+// TokenizeTextSubrecord one at a time without allocating. The bytes must outlive the cursor.
+class TokenCursor {
+public:
+    explicit TokenCursor(std::span<const uint8_t> bytes) : m_bytes(bytes) {}
+
+    bool Next(Token& tok);
+    // Variables of the Text token last returned by Next, in order. A name with upper-case letters is lower-cased
+    // into a cursor buffer, so VarRef::name is only valid until the next call.
+    bool NextVar(VarRef& var);
+
+    // Size of the plain rendering of everything returned so far.
+    size_t PlainLength() const { return m_plainLength; }
+
+    std::string_view TextOf(const Token& t) const {
+        const size_t off = t.byteOffset + (t.type == TokenType::BookImage ? 1 : 0);
+        return { reinterpret_cast<const char*>(m_bytes.data()) + off, t.textLength };
+    }
+    std::string_view TokenOf(const VarRef& v) const {
+        return { reinterpret_cast<const char*>(m_bytes.data()) + v.byteOffset, v.tokenLength };
+    }
+
+private:
+    std::span<const uint8_t> m_bytes;
+    size_t m_pos{};
+    size_t m_plainLength{};
+    size_t m_varBegin{};       // current Text run
+    size_t m_varPos{};
+    size_t m_varEnd{};
+    size_t m_varPlainBase{};
+    std::string m_name;
+};
+
+// Tokens and variables only; the plain and rich renderings are produced from the tokens when asked for, either
+// into a caller buffer (RenderPlain/RenderRich) or once into the text arena (Plain/Rich): the owning TextRsc's when
+// tokenized through TextSubrecord::EnsureTokens, otherwise a private one held by ownedArena.
 struct TokenizedText {
     std::vector<Token> tokens;
     std::vector<VarRef> vars;
-    std::string plain;
-    std::string rich;
+    uint32_t plainLength{};   // size of the plain rendering
     bool hasEndOfPage{};
     bool hasFontScript{};
+
+    std::span<const uint8_t> source;   // the tokenized bytes
+    TextArena* arena{};
+    std::shared_ptr<TextArena> ownedArena;
+
+    std::string_view TextOf(const Token& t) const {
+        const size_t off = t.byteOffset + (t.type == TokenType::BookImage ? 1 : 0);
+        return { reinterpret_cast<const char*>(source.data()) + off, t.textLength };
+    }
+    std::string_view TokenOf(const VarRef& v) const {
+        return { reinterpret_cast<const char*>(source.data()) + v.byteOffset, v.tokenLength };
+    }
+
+    // Rendered on first call and kept for the lifetime of the arena.
+    std::string_view Plain();
+    std::string_view Rich();
+
+    std::string_view plainCache;
+    std::string_view richCache;
+    bool plainReady{};
+    bool richReady{};
 };
 
-TokenizedText TokenizeTextSubrecord(const std::vector<uint8_t>& bytes);
+// arena == nullptr gives the result a private arena.
+TokenizedText TokenizeTextSubrecord(std::span<const uint8_t> bytes, TextArena* arena = nullptr);
+
+// Append the plain (text and line breaks) or rich (with <pos>, <font>, <color>, ... tags) rendering to out.
+void RenderPlain(const TokenizedText& t, std::string& out);
+// Streams the plain rendering straight from a subrecord's bytes, without tokenizing into a TokenizedText.
+void RenderPlain(std::span<const uint8_t> bytes, std::string& out);
+void RenderRich(const TokenizedText& t, std::string& out);
+
+// Inverse of RenderRich: encodes rich (or plain) text back into subrecord bytes. Line breaks become lineBreak
+// (NewLine, EndOfLineLeft or EndOfLineCenter); anything that is not one of RenderRich's tags is kept as text, and
+// characters outside ASCII become '?'. Never produces the 0xFF/0xFE separators.
+void EncodeTextSubrecord(std::string_view rich, std::vector<uint8_t>& out, TokenType lineBreak = TokenType::EndOfLineLeft);
 
 }
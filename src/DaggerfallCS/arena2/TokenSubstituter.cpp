@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "TokenSubstituter.h"
+#include "../util/NameHash.h"
+
+namespace arena2 {
+
+static inline bool IsNameChar(unsigned char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+void TokenSubstituter::Clear() {
+    m_slots.clear();
+    m_pool.clear();
+    m_count = 0;
+    m_minLength = SIZE_MAX;
+    m_maxLength = 0;
+}
+
+void TokenSubstituter::Build(const std::vector<std::pair<std::string_view, std::string_view>>& tokens) {
+    Clear();
+
+    // Only %name tokens can ever be replaced; _name_ tokens were never substituted (the name run swallows the
+    // closing underscore), so they are not compiled in either.
+    std::vector<std::pair<std::string_view, std::string_view>> live;
+    for (const auto& [token, value] : tokens) {
+        if (token.size() < 2 || token[0] != '%' || value.empty()) continue;
+        const std::string_view name = token.substr(1);
+        if (!std::all_of(name.begin(), name.end(), [](char c) { return IsNameChar(static_cast<unsigned char>(c)); })) continue;
+        live.emplace_back(name, value);
+    }
+    if (live.empty()) return;
+
+    size_t size = 16;
+    while (size < live.size() * 2) size <<= 1;
+    m_slots.assign(size, Slot{});
+    const size_t mask = size - 1;
+
+    for (const auto& [name, value] : live) {
+        uint32_t h = winutil::kFnv1aBasis;
+        for (char c : name) h = winutil::Fnv1aStep(h, static_cast<uint8_t>(c));
+        if (Lookup(h, name)) continue;   // duplicate token: the first value wins
+
+        size_t i = h & mask;
+        while (m_slots[i].keyLength) i = (i + 1) & mask;
+        Slot& s = m_slots[i];
+        s.hash = h;
+        s.keyOffset = static_cast<uint32_t>(m_pool.size());
+        s.keyLength = static_cast<uint32_t>(name.size());
+        m_pool.append(name);
+        s.valueOffset = static_cast<uint32_t>(m_pool.size());
+        s.valueLength = static_cast<uint32_t>(value.size());
+        m_pool.append(value);
+
+        m_count++;
+        m_minLength = std::min(m_minLength, name.size());
+        m_maxLength = std::max(m_maxLength, name.size());
+    }
+}
+
+const TokenSubstituter::Slot* TokenSubstituter::Lookup(uint32_t hash, std::string_view name) const {
+    if (m_slots.empty()) return nullptr;
+    const size_t mask = m_slots.size() - 1;
+    for (size_t i = hash & mask; m_slots[i].keyLength; i = (i + 1) & mask) {
+        const Slot& s = m_slots[i];
+        if (s.hash == hash && s.keyLength == name.size() && memcmp(m_pool.data() + s.keyOffset, name.data(), name.size()) == 0) return &s;
+    }
+    return nullptr;
+}
+
+void TokenSubstituter::Apply(std::string_view in, std::string& out) const {
+    if (m_count == 0) {
+        out.append(in);
+        return;
+    }
+
+    const char* data = in.data();
+    const size_t n = in.size();
+    size_t copied = 0;
+    size_t i = 0;
+    while (i < n) {
+        const void* hit = memchr(data + i, '%', n - i);
+        if (!hit) break;
+        const size_t pct = static_cast<const char*>(hit) - data;
+
+        // The token is the whole name run, so it is hashed while it is measured.
+        size_t j = pct + 1;
+        uint32_t h = winutil::kFnv1aBasis;
+        while (j < n && IsNameChar(static_cast<unsigned char>(data[j]))) h = winutil::Fnv1aStep(h, static_cast<uint8_t>(data[j++]));
+        const size_t length = j - pct - 1;
+
+        if (length >= m_minLength && length <= m_maxLength) {
+            if (const Slot* s = Lookup(h, std::string_view(data + pct + 1, length))) {
+                out.append(data + copied, pct - copied);
+                out.append(m_pool.data() + s->valueOffset, s->valueLength);
+                copied = j;
+            }
+        }
+        i = length ? j : pct + 1;
+    }
+    out.append(data + copied, n - copied);
+}
+
+std::string TokenSubstituter::Apply(std::string_view in) const {
+    std::string out;
+    out.reserve(in.size());
+    Apply(in, out);
+    return out;
+}
+
+} // namespace arena2
@@ -0,0 +1,39 @@
+#pragma once
+#include "../pch.h"
+
+namespace arena2 {
+
+// Replaces %name macro tokens (a '%' followed by the longest run of [A-Za-z0-9_]) with user-supplied values in
+// a single pass. Build compiles the token set into a flat open-addressed table, so Apply allocates nothing per
+// token; it is const and safe to call from several threads.
+class TokenSubstituter {
+public:
+    // Tokens with an empty value, and tokens that are not of the %name form, are skipped.
+    void Build(const std::vector<std::pair<std::string_view, std::string_view>>& tokens);
+    void Clear();
+
+    // Appends the substituted text to out.
+    void Apply(std::string_view in, std::string& out) const;
+    std::string Apply(std::string_view in) const;
+
+    size_t Size() const { return m_count; }
+
+private:
+    struct Slot {
+        uint32_t hash{};
+        uint32_t keyOffset{};
+        uint32_t keyLength{};     // 0 = empty slot
+        uint32_t valueOffset{};
+        uint32_t valueLength{};
+    };
+
+    const Slot* Lookup(uint32_t hash, std::string_view name) const;
+
+    std::vector<Slot> m_slots;    // power-of-two size, at most half full
+    std::string m_pool;           // names (without the '%') and values, back to back
+    size_t m_count{};
+    size_t m_minLength{ SIZE_MAX };
+    size_t m_maxLength{};
+};
+
+} // namespace arena2
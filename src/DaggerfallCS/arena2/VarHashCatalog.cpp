@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "VarHashCatalog.h"
 #include "../util/WinUtil.h"
+#include "../util/Hash64.h"
 
 namespace arena2 {
 
@@ -24,6 +25,16 @@ static std::string ToLowerAscii(std::string s) {
     return s;
 }
 
+uint64_t VarHashCatalog::Fingerprint() const {
+    uint64_t sum = hashToNames.size();
+    for (const auto& [hash, names] : hashToNames) {
+        uint64_t h = winutil::Hash64(&hash, sizeof(hash));
+        for (const auto& n : names) h = winutil::Hash64(n.data(), n.size() + 1, h);   // + 1: the terminator separates names
+        sum += h;
+    }
+    return sum;
+}
+
 uint32_t ComputeVarHash(std::string_view nameLowerAscii) {
     // UESP: val = (val<<1) + *ptr for each character byte.
     uint32_t val = 0;
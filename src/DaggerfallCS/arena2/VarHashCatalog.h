@@ -13,6 +13,9 @@ struct VarHashCatalog {
         auto it = hashToNames.find(hash);
         return (it == hashToNames.end()) ? nullptr : &it->second;
     }
+
+    // Order-independent hash of the whole table, so caches of resolved names can tell when it changed.
+    uint64_t Fingerprint() const;
 };
 
 uint32_t ComputeVarHash(std::string_view nameLowerAscii);
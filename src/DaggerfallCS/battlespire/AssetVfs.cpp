@@ -0,0 +1,156 @@
+#include "pch.h"
+#include "AssetVfs.h"
+#include "../util/NameHash.h"
+#include "../util/WinUtil.h"
+
+namespace battlespire {
+
+void AssetVfs::MountDirectory(const std::filesystem::path& dir, int priority) {
+    m_mounts.push_back({ priority, dir, nullptr });
+}
+
+void AssetVfs::MountArchive(const BsaArchive& archive, int priority) {
+    // Non-owning alias: the caller keeps the archive alive.
+    m_mounts.push_back({ priority, {}, std::shared_ptr<const BsaArchive>(std::shared_ptr<const BsaArchive>(), &archive) });
+}
+
+void AssetVfs::MountArchive(std::shared_ptr<const BsaArchive> archive, int priority) {
+    if (!archive) return;
+    m_mounts.push_back({ priority, {}, std::move(archive) });
+}
+
+void AssetVfs::Clear() {
+    m_mounts.clear();
+    m_locations.clear();
+    m_names.clear();
+    m_nameSlots.clear();
+    m_stemSlots.clear();
+    m_nameCount = 0;
+}
+
+void AssetVfs::Add(std::string name, AssetLocation loc) {
+    m_locations.push_back(std::move(loc));
+    m_names.push_back(std::move(name));
+}
+
+void AssetVfs::BuildSlots() {
+    size_t cap = 16;
+    while (cap < m_locations.size() * 2) cap <<= 1;
+    const size_t mask = cap - 1;
+    m_nameSlots.assign(cap, 0);
+    m_stemSlots.assign(cap, 0);
+    m_nameCount = 0;
+
+    // Locations are in priority order, so the first one per name wins and later ones join its shadow chain.
+    for (size_t i = 0; i < m_locations.size(); ++i) {
+        const uint32_t slot = static_cast<uint32_t>(i + 1);
+        const std::string_view name = m_names[i];
+
+        size_t p = winutil::HashFolded(name) & mask;
+        while (m_nameSlots[p] && !winutil::EqualsFolded(m_names[m_nameSlots[p] - 1], name)) p = (p + 1) & mask;
+        if (!m_nameSlots[p]) {
+            m_nameSlots[p] = slot;
+            m_nameCount++;
+        } else {
+            uint32_t tail = m_nameSlots[p];
+            while (m_locations[tail - 1].shadowed) tail = m_locations[tail - 1].shadowed;
+            m_locations[tail - 1].shadowed = slot;
+        }
+
+        const std::string_view stem = winutil::NameStem(name);
+        p = winutil::HashFolded(stem) & mask;
+        while (m_stemSlots[p] && !winutil::EqualsFolded(winutil::NameStem(m_names[m_stemSlots[p] - 1]), stem)) p = (p + 1) & mask;
+        if (!m_stemSlots[p]) m_stemSlots[p] = slot;
+    }
+}
+
+void AssetVfs::BuildIndex() {
+    m_locations.clear();
+    m_names.clear();
+    std::stable_sort(m_mounts.begin(), m_mounts.end(), [](const Mount& a, const Mount& b) { return a.priority > b.priority; });
+
+    for (size_t mi = 0; mi < m_mounts.size(); ++mi) {
+        const Mount& m = m_mounts[mi];
+        if (m.archive) {
+            for (const auto& e : m.archive->entries) {
+                AssetLocation loc;
+                loc.mount = static_cast<uint32_t>(mi);
+                loc.archive = m.archive.get();
+                loc.entry = &e;
+                loc.size = e.packedSize;
+                Add(e.name, std::move(loc));
+            }
+            continue;
+        }
+
+        std::error_code ec;
+        std::filesystem::directory_iterator it(m.dir, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            std::error_code fec;
+            if (!it->is_regular_file(fec)) continue;
+            AssetLocation loc;
+            loc.mount = static_cast<uint32_t>(mi);
+            loc.loosePath = it->path();
+            loc.size = it->file_size(fec);
+            if (fec) continue;
+            Add(winutil::NarrowUtf8(it->path().filename().wstring()), std::move(loc));
+        }
+    }
+    BuildSlots();
+}
+
+const AssetLocation* AssetVfs::Find(std::string_view name) const {
+    if (m_nameSlots.empty()) return nullptr;
+    const size_t mask = m_nameSlots.size() - 1;
+    for (size_t p = winutil::HashFolded(name) & mask; m_nameSlots[p]; p = (p + 1) & mask) {
+        if (winutil::EqualsFolded(m_names[m_nameSlots[p] - 1], name)) return &m_locations[m_nameSlots[p] - 1];
+    }
+    return nullptr;
+}
+
+const AssetLocation* AssetVfs::FindByStem(std::string_view stem, std::string_view ext) const {
+    if (m_nameSlots.empty()) return nullptr;
+    if (!ext.empty()) {
+        // stem + ext is hashed and compared in two pieces instead of being concatenated.
+        const size_t mask = m_nameSlots.size() - 1;
+        for (size_t p = winutil::HashFolded(ext, winutil::HashFolded(stem)) & mask; m_nameSlots[p]; p = (p + 1) & mask) {
+            const std::string_view name = m_names[m_nameSlots[p] - 1];
+            if (name.size() == stem.size() + ext.size() && winutil::EqualsFolded(name.substr(0, stem.size()), stem) &&
+                winutil::EqualsFolded(name.substr(stem.size()), ext)) {
+                return &m_locations[m_nameSlots[p] - 1];
+            }
+        }
+        return nullptr;
+    }
+    const size_t mask = m_stemSlots.size() - 1;
+    for (size_t p = winutil::HashFolded(stem) & mask; m_stemSlots[p]; p = (p + 1) & mask) {
+        if (winutil::EqualsFolded(winutil::NameStem(m_names[m_stemSlots[p] - 1]), stem)) return &m_locations[m_stemSlots[p] - 1];
+    }
+    return nullptr;
+}
+
+const AssetLocation* AssetVfs::Next(const AssetLocation& loc) const {
+    return loc.shadowed ? &m_locations[loc.shadowed - 1] : nullptr;
+}
+
+bool AssetVfs::Read(const AssetLocation& loc, std::vector<uint8_t>& outBytes, std::wstring* err) const {
+    outBytes.clear();
+    if (loc.archive && loc.entry) return loc.archive->ReadEntryData(*loc.entry, outBytes, err);
+
+    std::ifstream f(loc.loosePath, std::ios::binary);
+    if (!f) {
+        if (err) *err = L"Failed to open " + loc.loosePath.wstring();
+        return false;
+    }
+    outBytes.resize(static_cast<size_t>(loc.size));
+    if (!outBytes.empty()) f.read(reinterpret_cast<char*>(outBytes.data()), static_cast<std::streamsize>(outBytes.size()));
+    if (!f.good() && !f.eof()) {
+        outBytes.clear();
+        if (err) *err = L"Failed to read " + loc.loosePath.wstring();
+        return false;
+    }
+    outBytes.resize(static_cast<size_t>(f.gcount()));
+    return true;
+}
+
+} // namespace battlespire
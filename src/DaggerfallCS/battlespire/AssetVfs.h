@@ -0,0 +1,62 @@
+#pragma once
+#include "../pch.h"
+#include "BattlespireFormats.h"
+
+namespace battlespire {
+
+// One resolved asset: either a loose file under a mounted directory or an entry of a mounted archive.
+struct AssetLocation {
+    uint32_t mount{};
+    const BsaArchive* archive{};   // null for loose files
+    const BsaEntry* entry{};
+    std::filesystem::path loosePath;
+    uint64_t size{};               // packed size for archive entries, file size for loose files
+    uint32_t shadowed{};           // index + 1 of the next lower-priority location with the same name, 0 = none
+};
+
+// Priority-ordered view over loose directories and BSA archives with a single case-folded name index.
+// Mount everything, call BuildIndex once, then resolve names without touching the filesystem.
+class AssetVfs {
+public:
+    // Higher priority wins; equal priorities keep mount order. Directories are listed (non-recursively)
+    // by BuildIndex; a missing directory simply contributes nothing.
+    void MountDirectory(const std::filesystem::path& dir, int priority);
+    // Borrowed archive: it must outlive the index.
+    void MountArchive(const BsaArchive& archive, int priority);
+    void MountArchive(std::shared_ptr<const BsaArchive> archive, int priority);
+    void Clear();
+    void BuildIndex();
+
+    const AssetLocation* Find(std::string_view name) const;
+    // Same matching as BsaArchive::FindEntryByStem: with ext the name must equal stem + ext.
+    const AssetLocation* FindByStem(std::string_view stem, std::string_view ext = {}) const;
+    // Lower-priority location the given one shadows, for callers that fall back when a read or decode fails.
+    const AssetLocation* Next(const AssetLocation& loc) const;
+
+    bool Read(const AssetLocation& loc, std::vector<uint8_t>& outBytes, std::wstring* err) const;
+
+    size_t MountCount() const { return m_mounts.size(); }
+    size_t IndexedCount() const { return m_nameCount; }
+
+private:
+    struct Mount {
+        int priority{};
+        std::filesystem::path dir;
+        std::shared_ptr<const BsaArchive> archive;
+    };
+
+    void Add(std::string name, AssetLocation loc);
+    void BuildSlots();
+
+    std::vector<Mount> m_mounts;
+    std::vector<AssetLocation> m_locations;
+    std::vector<std::string> m_names;      // parallel to m_locations, as spelled in the directory or archive
+    // Case-folded open-addressed tables like BsaArchive's (slot value is location index + 1, 0 = empty), so
+    // lookups hash and compare the caller's name in place. m_nameSlots holds the highest-priority location per
+    // name; m_stemSlots the first location per name up to the first '.'.
+    std::vector<uint32_t> m_nameSlots;
+    std::vector<uint32_t> m_stemSlots;
+    size_t m_nameCount{};
+};
+
+} // namespace battlespire
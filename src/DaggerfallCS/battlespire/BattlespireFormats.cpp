@@ -1,5 +1,8 @@
 #include "pch.h"
 #include "BattlespireFormats.h"
+#include "../util/Hash64.h"
+#include "../util/NameHash.h"
+#include "../util/Parallel.h"
 #include <functional>
 
 namespace battlespire {
@@ -131,18 +134,22 @@ bool BsaArchive::LoadFromFile(const std::filesystem::path& filePath, BsaArchive&
         return false;
     }
 
-    if (!ReadAllBytes(filePath, out.bytes, err)) {
+    out.file = winutil::MappedFile::Open(filePath, err);
+    if (!out.file) {
+        out = {};
         return false;
     }
 
-    if (out.bytes.size() < 4) {
+    const uint8_t* data = out.file->Data();
+    const size_t dataSize = out.file->Size();
+    if (dataSize < 4) {
         if (err) *err = L"BSA is too small.";
         out = {};
         return false;
     }
 
-    out.recordCount = ReadU16(out.bytes.data());
-    out.recordType = ReadU16(out.bytes.data() + 2);
+    out.recordCount = ReadU16(data);
+    out.recordType = ReadU16(data + 2);
 
     size_t entrySize = 18;
     bool hasNames = true;
@@ -155,13 +162,13 @@ bool BsaArchive::LoadFromFile(const std::filesystem::path& filePath, BsaArchive&
     }
 
     const size_t footerBytes = size_t(out.recordCount) * entrySize;
-    if (out.bytes.size() < 4 + footerBytes) {
+    if (dataSize < 4 + footerBytes) {
         if (err) *err = L"BSA footer is truncated.";
         out = {};
         return false;
     }
 
-    const size_t footerStart = out.bytes.size() - footerBytes;
+    const size_t footerStart = dataSize - footerBytes;
     size_t runningOffset = (out.recordType == 0x100 || out.recordType == 0x200) ? 4 : 2;
 
     out.entries.clear();
@@ -174,23 +181,23 @@ bool BsaArchive::LoadFromFile(const std::filesystem::path& filePath, BsaArchive&
 
         if (out.recordType == 0x100) {
             char nameBuf[13]{};
-            memcpy(nameBuf, out.bytes.data() + p, 12);
+            memcpy(nameBuf, data + p, 12);
             e.name = nameBuf;
-            e.compressionFlag = ReadU16(out.bytes.data() + p + 12);
-            e.packedSize = ReadU32(out.bytes.data() + p + 14);
+            e.compressionFlag = ReadU16(data + p + 12);
+            e.packedSize = ReadU32(data + p + 14);
         } else if (out.recordType == 0x200) {
-            e.compressionFlag = ReadU16(out.bytes.data() + p + 0);
-            uint16_t nameId = ReadU16(out.bytes.data() + p + 2);
+            e.compressionFlag = ReadU16(data + p + 0);
+            uint16_t nameId = ReadU16(data + p + 2);
             e.name = "REC_" + std::to_string(nameId);
-            e.packedSize = ReadU32(out.bytes.data() + p + 4);
+            e.packedSize = ReadU32(data + p + 4);
         } else {
             e.compressionFlag = 0;
-            uint16_t nameId = ReadU16(out.bytes.data() + p + 0);
+            uint16_t nameId = ReadU16(data + p + 0);
             e.name = "REC_" + std::to_string(nameId);
-            e.packedSize = ReadU32(out.bytes.data() + p + 2);
+            e.packedSize = ReadU32(data + p + 2);
         }
 
-        if (e.packedSize > out.bytes.size() || runningOffset > out.bytes.size() - e.packedSize || runningOffset + e.packedSize > footerStart) {
+        if (e.packedSize > dataSize || runningOffset > dataSize - e.packedSize || runningOffset + e.packedSize > footerStart) {
             if (err) *err = L"BSA entry layout is invalid.";
             out = {};
             return false;
@@ -206,101 +213,568 @@ bool BsaArchive::LoadFromFile(const std::filesystem::path& filePath, BsaArchive&
         }
     }
 
+    out.FinalizeLoad();
     return true;
 }
 
-const BsaEntry* BsaArchive::FindEntryCaseInsensitive(std::string_view name) const {
-    std::string needle(name);
-    for (auto& c : needle) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+void BsaArchive::FinalizeLoad() {
+    BuildNameIndex();
+    seekIndexes = std::make_shared<SeekIndexStore>();
+
+    static std::atomic<uint32_t> nextCacheId{ 1 };
+    cacheId = nextCacheId.fetch_add(1);
+}
+
+void BsaArchive::BuildNameIndex() {
+    size_t cap = 16;
+    while (cap < entries.size() * 2) cap <<= 1;
+    const size_t mask = cap - 1;
 
-    for (const auto& e : entries) {
-        std::string n = e.name;
-        for (auto& c : n) c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
-        if (n == needle) return &e;
+    nameSlots.assign(cap, 0);
+    stemSlots.assign(cap, 0);
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const std::string_view name = entries[i].name;
+
+        // Duplicate names keep the first entry, matching the old linear search.
+        size_t p = winutil::HashFolded(name) & mask;
+        bool dup = false;
+        while (nameSlots[p]) {
+            if (winutil::EqualsFolded(entries[nameSlots[p] - 1].name, name)) { dup = true; break; }
+            p = (p + 1) & mask;
+        }
+        if (!dup) nameSlots[p] = static_cast<uint32_t>(i + 1);
+
+        // Stems may repeat across extensions; all are kept and probed in load order.
+        p = winutil::HashFolded(winutil::NameStem(name)) & mask;
+        while (stemSlots[p]) p = (p + 1) & mask;
+        stemSlots[p] = static_cast<uint32_t>(i + 1);
     }
+}
 
+const BsaEntry* BsaArchive::FindEntryCaseInsensitive(std::string_view name) const {
+    if (nameSlots.empty()) return nullptr;
+    const size_t mask = nameSlots.size() - 1;
+    for (size_t p = winutil::HashFolded(name) & mask; nameSlots[p]; p = (p + 1) & mask) {
+        const BsaEntry& e = entries[nameSlots[p] - 1];
+        if (winutil::EqualsFolded(e.name, name)) return &e;
+    }
     return nullptr;
 }
 
-bool BsaArchive::DecompressLzss(const uint8_t* data, size_t size, std::vector<uint8_t>& outBytes, std::wstring* err) {
-    outBytes.clear();
-    if (!data || size == 0) return true;
+const BsaEntry* BsaArchive::FindEntryByStem(std::string_view stem, std::string_view ext) const {
+    if (stemSlots.empty()) return nullptr;
+    const size_t mask = stemSlots.size() - 1;
+    // With an extension this is an exact match on stem + ext, so stems that themselves contain a '.' still resolve.
+    for (size_t p = winutil::HashFolded(winutil::NameStem(stem)) & mask; stemSlots[p]; p = (p + 1) & mask) {
+        const BsaEntry& e = entries[stemSlots[p] - 1];
+        const std::string_view name = e.name;
+        if (ext.empty()) {
+            if (!winutil::EqualsFolded(winutil::NameStem(name), stem)) continue;
+        } else {
+            if (name.size() != stem.size() + ext.size()) continue;
+            if (!winutil::EqualsFolded(name.substr(0, stem.size()), stem) || !winutil::EqualsFolded(name.substr(stem.size()), ext)) continue;
+        }
+        return &e;
+    }
+    return nullptr;
+}
 
-    const size_t maxOutBytes = std::min<size_t>(64u * 1024u * 1024u, std::max<size_t>(size * 64u, size + 4096u));
+static size_t LzssSafetyLimit(size_t packedSize) {
+    return std::min<size_t>(64u * 1024u * 1024u, std::max<size_t>(packedSize * 64u, packedSize + 4096u));
+}
 
-    std::array<uint8_t, 4096> window{};
-    for (size_t i = 0; i < 4078; ++i) window[i] = static_cast<uint8_t>(' ');
+// Ring contents a back-reference sees before the output has filled that slot (bsatool pre-fills with spaces).
+static uint8_t LzssInitialWindowByte(size_t ringPos) {
+    return ringPos < 4078 ? static_cast<uint8_t>(' ') : 0;
+}
 
-    size_t pos = 4078;
+// Rebuilds the reference decoder's ring window from the first n output bytes.
+static void CaptureLzssCheckpoint(const uint8_t* out, size_t n, size_t ip, unsigned flags, int bitsLeft, LzssCheckpoint& cp) {
+    cp.inPos = static_cast<uint32_t>(ip);
+    cp.outPos = static_cast<uint32_t>(n);
+    cp.flags = static_cast<uint8_t>(flags);
+    cp.bitsLeft = static_cast<uint8_t>(bitsLeft);
+    for (size_t r = 0; r < cp.window.size(); ++r) cp.window[r] = LzssInitialWindowByte(r);
+    for (size_t j = (n > 4096 ? n - 4096 : 0); j < n; ++j) cp.window[(4078 + j) & 0xFFFu] = out[j];
+}
+
+// Decodes straight into a flat output buffer. The ring window of the reference decoder always holds the
+// last 4096 output bytes, so a back-reference at ring offset o is a copy from distance (pos - o) & 0xFFF
+// (0 meaning 4096) in the output itself; only references that reach before the first byte read the
+// initial window contents. reserve(need) must make out hold at least need bytes or return false.
+template <typename ReserveFn>
+static bool DecodeLzssFlat(const uint8_t* data, size_t size, size_t maxOut, uint8_t*& out, size_t& outSize, ReserveFn reserve, LzssSeekIndex* seekIndex, std::wstring* err) {
+    size_t n = 0;
     size_t ip = 0;
 
+    size_t nextCheckpoint = 0;
+    if (seekIndex) {
+        if (seekIndex->interval == 0) seekIndex->interval = LzssSeekIndex::kDefaultInterval;
+        seekIndex->checkpoints.clear();
+        seekIndex->decodedSize = 0;
+        seekIndex->checkpoints.emplace_back();
+        CaptureLzssCheckpoint(out, 0, 0, 0, 0, seekIndex->checkpoints.back());
+        nextCheckpoint = seekIndex->interval;
+    }
+
     while (ip < size) {
-        uint8_t flags = data[ip++];
-        for (int bit = 0; bit < 8; ++bit) {
-            if (ip >= size) break;
+        unsigned flags = data[ip++];
+        for (int bit = 0; bit < 8 && ip < size; ++bit, flags >>= 1) {
+            if (seekIndex && n >= nextCheckpoint) {
+                seekIndex->checkpoints.emplace_back();
+                CaptureLzssCheckpoint(out, n, ip, flags, 8 - bit, seekIndex->checkpoints.back());
+                nextCheckpoint = (n / seekIndex->interval + 1) * seekIndex->interval;
+            }
 
-            bool literal = ((flags >> bit) & 1u) != 0;
-            if (literal) {
-                uint8_t b = data[ip++];
-                outBytes.push_back(b);
-                if (outBytes.size() > maxOutBytes) {
-                    if (err) *err = L"LZSS decode exceeded safety output limit.";
-                    return false;
+            if (flags & 1u) {
+                if (n + 1 > maxOut) { if (err) *err = L"LZSS decode exceeded safety output limit."; return false; }
+                if (!reserve(n + 1)) return false;
+                out[n++] = data[ip++];
+                continue;
+            }
+
+            if (ip + 1 >= size) { if (err) *err = L"LZSS stream truncated in back-reference token."; return false; }
+            const uint8_t b0 = data[ip++];
+            const uint8_t b1 = data[ip++];
+            const size_t offset = size_t(b0) | (size_t(b1 & 0xF0u) << 4);
+            const size_t length = size_t(b1 & 0x0Fu) + 3;
+
+            if (n + length > maxOut) { if (err) *err = L"LZSS decode exceeded safety output limit."; return false; }
+            if (!reserve(n + length)) return false;
+
+            size_t dist = (4078 + n - offset) & 0xFFFu;
+            if (dist == 0) dist = 4096;
+
+            uint8_t* dst = out + n;
+            if (dist <= n) {
+                const uint8_t* src = dst - dist;
+                if (dist >= length) {
+                    memcpy(dst, src, length);
+                } else {
+                    for (size_t k = 0; k < length; ++k) dst[k] = src[k];
                 }
-                window[pos] = b;
-                pos = (pos + 1) & 0xFFFu;
             } else {
-                if (ip + 1 >= size) { if (err) *err = L"LZSS stream truncated in back-reference token."; return false; }
-                uint8_t b0 = data[ip++];
-                uint8_t b1 = data[ip++];
-                size_t offset = size_t(b0) | (size_t(b1 & 0xF0u) << 4);
-                size_t length = size_t(b1 & 0x0Fu) + 3;
                 for (size_t k = 0; k < length; ++k) {
-                    uint8_t b = window[(offset + k) & 0xFFFu];
-                    outBytes.push_back(b);
-                    if (outBytes.size() > maxOutBytes) {
-                        if (err) *err = L"LZSS decode exceeded safety output limit.";
-                        return false;
-                    }
-                    window[pos] = b;
-                    pos = (pos + 1) & 0xFFFu;
+                    if (n + k >= dist) dst[k] = out[n + k - dist];
+                    else dst[k] = LzssInitialWindowByte((4078 + n + k - dist) & 0xFFFu);
                 }
             }
+            n += length;
         }
     }
 
+    outSize = n;
+    if (seekIndex) seekIndex->decodedSize = n;
     return true;
 }
 
-bool BsaArchive::ReadEntryData(const BsaEntry& entry, std::vector<uint8_t>& outBytes, std::wstring* err) const {
+bool BsaArchive::DecompressLzssRange(const uint8_t* data, size_t size, const LzssCheckpoint& cp, size_t from, size_t to, uint8_t* out, size_t& produced, std::wstring* err) {
+    produced = 0;
+    if (!data || from >= to || cp.outPos > from || cp.inPos > size) return from >= to;
+
+    std::array<uint8_t, 4096> window = cp.window;
+    size_t n = cp.outPos;
+    size_t ip = cp.inPos;
+    size_t pos = (4078 + n) & 0xFFFu;
+    unsigned flags = cp.flags;
+    int bitsLeft = cp.bitsLeft;
+
+    auto emit = [&](uint8_t b) {
+        if (n >= from) out[n - from] = b;
+        window[pos] = b;
+        pos = (pos + 1) & 0xFFFu;
+        ++n;
+    };
+
+    while (n < to) {
+        if (bitsLeft == 0) {
+            if (ip >= size) break;
+            flags = data[ip++];
+            bitsLeft = 8;
+        }
+        if (ip >= size) break;
+
+        const bool literal = (flags & 1u) != 0;
+        flags >>= 1;
+        --bitsLeft;
+
+        if (literal) {
+            emit(data[ip++]);
+            continue;
+        }
+
+        if (ip + 1 >= size) { if (err) *err = L"LZSS stream truncated in back-reference token."; return false; }
+        const uint8_t b0 = data[ip++];
+        const uint8_t b1 = data[ip++];
+        const size_t offset = size_t(b0) | (size_t(b1 & 0xF0u) << 4);
+        const size_t length = size_t(b1 & 0x0Fu) + 3;
+        for (size_t k = 0; k < length && n < to; ++k) emit(window[(offset + k) & 0xFFFu]);
+    }
+
+    produced = (n > from) ? std::min(n, to) - from : 0;
+    return true;
+}
+
+bool BsaArchive::DecompressLzss(const uint8_t* data, size_t size, std::vector<uint8_t>& outBytes, std::wstring* err, size_t sizeHint, LzssSeekIndex* seekIndex) {
     outBytes.clear();
+    if (!data || size == 0) return true;
 
-    if (entry.offset > bytes.size() || entry.packedSize > bytes.size() - entry.offset) {
-        if (err) *err = L"BSA entry points outside archive bounds.";
+    const size_t maxOutBytes = LzssSafetyLimit(size);
+
+    outBytes.resize(std::min(maxOutBytes, std::max<size_t>(sizeHint, size * 4u)));
+    uint8_t* out = outBytes.data();
+    auto reserve = [&](size_t need) {
+        if (need > outBytes.size()) {
+            outBytes.resize(std::min(maxOutBytes, std::max(need, outBytes.size() * 2)));
+            out = outBytes.data();
+        }
+        return true;
+    };
+
+    size_t n = 0;
+    if (!DecodeLzssFlat(data, size, maxOutBytes, out, n, reserve, seekIndex, err)) {
+        outBytes.clear();
         return false;
     }
+    outBytes.resize(n);
+    return true;
+}
+
+bool BsaArchive::DecompressLzssInto(const uint8_t* data, size_t size, uint8_t* out, size_t outCapacity, size_t& outSize, std::wstring* err) {
+    outSize = 0;
+    if (!data || size == 0) return true;
+
+    auto reserve = [&](size_t need) {
+        if (need <= outCapacity) return true;
+        if (err) *err = L"LZSS output buffer is too small.";
+        return false;
+    };
+    return DecodeLzssFlat(data, size, LzssSafetyLimit(size), out, outSize, reserve, nullptr, err);
+}
+
+// Greedy encoder with a hash chain over 3-byte prefixes. Matches only reference bytes already written (never
+// the initial window fill), up to 4095 back, so any decoder that honours the ring semantics reproduces data.
+void BsaArchive::CompressLzss(const uint8_t* data, size_t size, std::vector<uint8_t>& outBytes, size_t maxChain) {
+    outBytes.clear();
+    if (!data || size == 0) return;
+    outBytes.reserve(size + size / 8 + 1);
+
+    static constexpr size_t kMinMatch = 3;
+    static constexpr size_t kMaxMatch = 18;
+    static constexpr size_t kMaxDistance = 4095;
+    static constexpr size_t kHashBits = 14;
+
+    std::vector<int32_t> head(size_t(1) << kHashBits, -1);
+    std::vector<int32_t> prev(4096, -1);
+    auto hashAt = [&](size_t p) {
+        const uint32_t v = uint32_t(data[p]) | (uint32_t(data[p + 1]) << 8) | (uint32_t(data[p + 2]) << 16);
+        return (v * 2654435761u) >> (32 - kHashBits);
+    };
+    auto insert = [&](size_t p) {
+        if (p + kMinMatch > size) return;
+        const uint32_t h = hashAt(p);
+        prev[p & 0xFFF] = head[h];
+        head[h] = static_cast<int32_t>(p);
+    };
+
+    size_t flagPos = 0;
+    int bit = 8;
+    size_t i = 0;
+    while (i < size) {
+        if (bit == 8) {
+            flagPos = outBytes.size();
+            outBytes.push_back(0);
+            bit = 0;
+        }
+
+        size_t bestLen = 0;
+        size_t bestDist = 0;
+        const size_t maxLen = std::min(kMaxMatch, size - i);
+        if (maxLen >= kMinMatch) {
+            size_t chain = maxChain;
+            // Positions reached through prev[] are always within the last 4096 bytes, so their slots are intact.
+            for (int32_t cand = head[hashAt(i)]; cand >= 0 && chain-- > 0; cand = prev[size_t(cand) & 0xFFF]) {
+                const size_t dist = i - size_t(cand);
+                if (dist > kMaxDistance) break;
+                const uint8_t* a = data + cand;
+                const uint8_t* b = data + i;
+                if (a[bestLen] != b[bestLen]) continue;   // bestLen < maxLen here: a full-length match ends the search
+                size_t len = 0;
+                while (len < maxLen && a[len] == b[len]) ++len;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = dist;
+                    if (len == maxLen) break;
+                }
+            }
+        }
+
+        if (bestLen >= kMinMatch) {
+            const size_t offset = (4078 + i - bestDist) & 0xFFFu;
+            outBytes.push_back(static_cast<uint8_t>(offset & 0xFF));
+            outBytes.push_back(static_cast<uint8_t>(((offset >> 4) & 0xF0u) | (bestLen - kMinMatch)));
+            for (size_t k = 0; k < bestLen; ++k) insert(i + k);
+            i += bestLen;
+        } else {
+            outBytes[flagPos] |= static_cast<uint8_t>(1u << bit);
+            outBytes.push_back(data[i]);
+            insert(i);
+            ++i;
+        }
+        ++bit;
+    }
+}
+
+std::span<const uint8_t> BsaArchive::PayloadView(const BsaEntry& entry) const {
+    const size_t size = Size();
+    if (entry.offset > size || entry.packedSize > size - entry.offset) return {};
+    return { Data() + entry.offset, entry.packedSize };
+}
+
+BsaPayload BsaArchive::ReadEntryShared(const BsaEntry& entry, std::wstring* err) const {
+    if (entry.offset > Size() || entry.packedSize > Size() - entry.offset) {
+        if (err) *err = L"BSA entry points outside archive bounds.";
+        return nullptr;
+    }
 
-    const uint8_t* payload = bytes.data() + entry.offset;
+    const uint8_t* payload = Data() + entry.offset;
     const size_t payloadSize = entry.packedSize;
 
+    auto out = std::make_shared<std::vector<uint8_t>>();
     if (!IsBsaEntryCompressed(entry.compressionFlag)) {
-        outBytes.assign(payload, payload + payloadSize);
-        return true;
+        out->assign(payload, payload + payloadSize);
+        return out;
+    }
+
+    const bool cacheable = cacheId != 0 && &entry >= entries.data() && &entry < entries.data() + entries.size();
+    const uint32_t entryIndex = cacheable ? static_cast<uint32_t>(&entry - entries.data()) : 0;
+    const BsaEntryMeta* meta = cacheable ? MetaFor(entry) : nullptr;
+    if (cacheable) {
+        if (auto hit = BsaEntryCache::Instance().Find(cacheId, entryIndex)) return hit;
+        // Same bytes already decoded for another entry or archive: share them instead of decoding again.
+        if (meta) {
+            if (auto hit = BsaEntryCache::Instance().FindByContent(cacheId, entryIndex, meta->contentHash, meta->decodedSize)) return hit;
+        }
+    }
+
+    // Large entries collect seek checkpoints while they are decoded anyway; small ones are cheaper to redo.
+    std::shared_ptr<LzssSeekIndex> seekIndex;
+    if (cacheable && seekIndexes && payloadSize >= LzssSeekIndex::kDefaultInterval / 4 && !FindSeekIndex(entry)) {
+        seekIndex = std::make_shared<LzssSeekIndex>();
     }
 
     std::wstring lzErr;
-    if (DecompressLzss(payload, payloadSize, outBytes, &lzErr)) {
-        return true;
+    if (DecompressLzss(payload, payloadSize, *out, &lzErr, 0, seekIndex.get())) {
+        if (seekIndex && seekIndex->decodedSize >= 2 * seekIndex->interval) {
+            std::lock_guard<std::mutex> lock(seekIndexes->mutex);
+            seekIndexes->byEntry.emplace(entryIndex, std::move(seekIndex));
+        }
+        if (cacheable) return BsaEntryCache::Instance().Insert(cacheId, entryIndex, out, meta ? meta->contentHash : 0);
+        return out;
     }
 
     // Some archives mark entries with non-zero flags that are not LZSS payloads; fallback to raw bytes.
-    outBytes.assign(payload, payload + payloadSize);
+    out->assign(payload, payload + payloadSize);
     if (err) {
         *err = L"LZSS decode failed, falling back to raw payload: " + lzErr;
     }
+    return out;
+}
+
+std::shared_ptr<const LzssSeekIndex> BsaArchive::FindSeekIndex(const BsaEntry& entry) const {
+    if (!seekIndexes || &entry < entries.data() || &entry >= entries.data() + entries.size()) return nullptr;
+    std::lock_guard<std::mutex> lock(seekIndexes->mutex);
+    auto it = seekIndexes->byEntry.find(static_cast<uint32_t>(&entry - entries.data()));
+    return (it != seekIndexes->byEntry.end()) ? it->second : nullptr;
+}
+
+bool BsaArchive::ReadEntryRange(const BsaEntry& entry, size_t offset, size_t length, std::vector<uint8_t>& outBytes, std::wstring* err) const {
+    outBytes.clear();
+
+    auto payload = PayloadView(entry);
+    if (payload.size() != entry.packedSize) {
+        if (err) *err = L"BSA entry points outside archive bounds.";
+        return false;
+    }
+
+    auto slice = [&](std::span<const uint8_t> all) {
+        if (offset >= all.size()) return;
+        const size_t n = std::min(length, all.size() - offset);
+        outBytes.assign(all.data() + offset, all.data() + offset + n);
+    };
+
+    if (!IsBsaEntryCompressed(entry.compressionFlag)) {
+        slice(payload);
+        return true;
+    }
+
+    const bool inArchive = &entry >= entries.data() && &entry < entries.data() + entries.size();
+    if (cacheId && inArchive) {
+        if (auto hit = BsaEntryCache::Instance().Find(cacheId, static_cast<uint32_t>(&entry - entries.data()))) {
+            slice({ hit->data(), hit->size() });
+            return true;
+        }
+    }
+
+    if (auto index = FindSeekIndex(entry)) {
+        if (offset >= index->decodedSize) return true;
+        const size_t to = offset + std::min(length, index->decodedSize - offset);
+
+        auto cp = std::upper_bound(index->checkpoints.begin(), index->checkpoints.end(), offset,
+            [](size_t off, const LzssCheckpoint& c) { return off < c.outPos; });
+        if (cp != index->checkpoints.begin()) {
+            --cp;
+            outBytes.resize(to - offset);
+            size_t produced = 0;
+            if (DecompressLzssRange(payload.data(), payload.size(), *cp, offset, to, outBytes.data(), produced, err)) {
+                outBytes.resize(produced);
+                return true;
+            }
+            outBytes.clear();
+        }
+    }
+
+    auto decoded = ReadEntryShared(entry, err);
+    if (!decoded) return false;
+    slice({ decoded->data(), decoded->size() });
+    return true;
+}
+
+bool BsaArchive::ReadEntryView(const BsaEntry& entry, std::span<const uint8_t>& outView, BsaPayload& hold, std::wstring* err) const {
+    outView = {};
+    hold.reset();
+
+    if (!IsBsaEntryCompressed(entry.compressionFlag)) {
+        if (entry.offset > Size() || entry.packedSize > Size() - entry.offset) {
+            if (err) *err = L"BSA entry points outside archive bounds.";
+            return false;
+        }
+        outView = PayloadView(entry);
+        return true;
+    }
+
+    hold = ReadEntryShared(entry, err);
+    if (!hold) return false;
+    outView = { hold->data(), hold->size() };
+    return true;
+}
+
+bool BsaArchive::ReadEntryUncached(const BsaEntry& entry, std::span<const uint8_t>& outView, std::vector<uint8_t>& buffer, std::wstring* err) const {
+    outView = {};
+    buffer.clear();
+
+    if (entry.offset > Size() || entry.packedSize > Size() - entry.offset) {
+        if (err) *err = L"BSA entry points outside archive bounds.";
+        return false;
+    }
+    auto payload = PayloadView(entry);
+    if (!IsBsaEntryCompressed(entry.compressionFlag)) {
+        outView = payload;
+        return true;
+    }
+
+    const BsaEntryMeta* meta = MetaFor(entry);
+    std::wstring lzErr;
+    if (DecompressLzss(payload.data(), payload.size(), buffer, &lzErr, meta ? meta->decodedSize : 0)) {
+        outView = { buffer.data(), buffer.size() };
+        return true;
+    }
+
+    // Same raw-payload fallback as ReadEntryShared.
+    buffer.clear();
+    outView = payload;
+    if (err) *err = L"LZSS decode failed, falling back to raw payload: " + lzErr;
+    return true;
+}
+
+bool BsaArchive::ReadEntryData(const BsaEntry& entry, std::vector<uint8_t>& outBytes, std::wstring* err) const {
+    outBytes.clear();
+
+    if (entry.offset > Size() || entry.packedSize > Size() - entry.offset) {
+        if (err) *err = L"BSA entry points outside archive bounds.";
+        return false;
+    }
+
+    if (!IsBsaEntryCompressed(entry.compressionFlag)) {
+        const uint8_t* payload = Data() + entry.offset;
+        outBytes.assign(payload, payload + entry.packedSize);
+        return true;
+    }
+
+    auto decoded = ReadEntryShared(entry, err);
+    if (!decoded) return false;
+    outBytes = *decoded;
     return true;
 }
 
+const wchar_t* BsaContentKindName(BsaContentKind kind) {
+    switch (kind) {
+        case BsaContentKind::Bs6:     return L"BS6 level";
+        case BsaContentKind::Model3d: return L"3D model";
+        case BsaContentKind::Bsi:     return L"BSI image";
+        case BsaContentKind::Flc:     return L"FLC animation";
+        case BsaContentKind::Text:    return L"Text";
+        case BsaContentKind::Binary:  return L"Binary";
+        default:                      return L"Unknown";
+    }
+}
+
+static bool NameHasExtension(std::string_view name, std::string_view ext) {
+    if (name.size() < ext.size()) return false;
+    for (size_t i = 0; i < ext.size(); ++i) {
+        if (toupper(static_cast<unsigned char>(name[name.size() - ext.size() + i])) != ext[i]) return false;
+    }
+    return true;
+}
+
+BsaContentKind SniffBsaContentKind(std::string_view entryName, const std::vector<uint8_t>& bytes) {
+    if (NameHasExtension(entryName, ".BS6")) {
+        Bs6FileSummary bs6;
+        if (Bs6FileSummary::TrySummarize(bytes, bs6, nullptr)) return BsaContentKind::Bs6;
+    } else if (NameHasExtension(entryName, ".3D")) {
+        B3dFileSummary b3d;
+        if (B3dFileSummary::TryParse(bytes, b3d, nullptr)) return BsaContentKind::Model3d;
+    } else if (NameHasExtension(entryName, ".BSI")) {
+        return BsaContentKind::Bsi;
+    } else if (NameHasExtension(entryName, ".FLC")) {
+        return BsaContentKind::Flc;
+    }
+
+    if (bytes.empty()) return BsaContentKind::Text;
+    size_t control = 0;
+    const size_t sample = std::min<size_t>(bytes.size(), 4096);
+    for (size_t i = 0; i < sample; ++i) {
+        uint8_t b = bytes[i];
+        if (b < 32 && b != 9 && b != 10 && b != 13) control++;
+    }
+    return (control * 8 < sample) ? BsaContentKind::Text : BsaContentKind::Binary;
+}
+
+const BsaEntryMeta* BsaArchive::MetaFor(const BsaEntry& entry) const {
+    if (entryMeta.size() != entries.size()) return nullptr;
+    if (&entry < entries.data() || &entry >= entries.data() + entries.size()) return nullptr;
+    return &entryMeta[static_cast<size_t>(&entry - entries.data())];
+}
+
+void BsaArchive::ComputeEntryMeta(size_t workers) {
+    std::vector<BsaEntryMeta> meta(entries.size());
+    winutil::ParallelFor(entries.size(), workers, [&](size_t i, size_t) {
+        const BsaEntry& e = entries[i];
+        std::vector<uint8_t> bytes;
+        auto payload = PayloadView(e);
+        if (IsBsaEntryCompressed(e.compressionFlag)) {
+            if (!DecompressLzss(payload.data(), payload.size(), bytes, nullptr)) bytes.assign(payload.begin(), payload.end());
+        } else {
+            bytes.assign(payload.begin(), payload.end());
+        }
+        meta[i].decodedSize = static_cast<uint32_t>(bytes.size());
+        meta[i].kind = SniffBsaContentKind(e.name, bytes);
+        meta[i].contentHash = winutil::Hash64(bytes.data(), bytes.size());
+    });
+    entryMeta = std::move(meta);
+}
+
 bool FlcFile::NormalizeLeadingPrefix(std::vector<uint8_t>& bytes, bool& strippedPrefix) {
     strippedPrefix = false;
 
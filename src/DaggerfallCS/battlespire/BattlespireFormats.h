@@ -1,5 +1,7 @@
 #pragma once
 #include "../pch.h"
+#include "../util/MappedFile.h"
+#include "BsaEntryCache.h"
 
 namespace battlespire {
 
@@ -31,19 +33,107 @@ struct BsaEntry {
     uint16_t compressionFlag{};
 };
 
+enum class BsaContentKind : uint8_t { Unknown, Bs6, Model3d, Bsi, Flc, Text, Binary };
+
+const wchar_t* BsaContentKindName(BsaContentKind kind);
+
+// Same checks the entry preview makes: extension plus a successful summary parse for BS6/3D, extension for
+// BSI/FLC, then the printable-text heuristic on the first 4 KB.
+BsaContentKind SniffBsaContentKind(std::string_view entryName, const std::vector<uint8_t>& bytes);
+
+struct BsaEntryMeta {
+    uint32_t decodedSize{};
+    BsaContentKind kind{ BsaContentKind::Unknown };
+    uint64_t contentHash{};     // winutil::Hash64 of the decoded bytes
+};
+
+// Resume point inside an LZSS stream, taken at a token boundary: the 4 KB ring window plus stream positions.
+struct LzssCheckpoint {
+    uint32_t inPos{};       // next input byte
+    uint32_t outPos{};      // decoded bytes produced so far
+    uint8_t flags{};        // unread flag bits of the current group (already shifted down)
+    uint8_t bitsLeft{};     // 0 = the next input byte is a flag byte
+    std::array<uint8_t, 4096> window{};
+};
+
+// Checkpoints every `interval` decoded bytes, collected during a full decode so later ranged reads can resume
+// from the nearest one instead of byte 0.
+struct LzssSeekIndex {
+    static constexpr size_t kDefaultInterval = 64u * 1024u;
+
+    size_t interval{ kDefaultInterval };
+    size_t decodedSize{};
+    std::vector<LzssCheckpoint> checkpoints;   // ascending outPos; checkpoints[0] is the stream start
+};
+
 struct BsaArchive {
     std::filesystem::path sourcePath;
     uint16_t recordCount{};
     uint16_t recordType{};
-    std::vector<uint8_t> bytes;
+    uint32_t cacheId{};   // unique per successful load; keys this archive's entries in BsaEntryCache
+    std::shared_ptr<const winutil::MappedFile> file;
     std::vector<BsaEntry> entries;
+    std::vector<BsaEntryMeta> entryMeta;   // parallel to entries once known (sidecar or ComputeEntryMeta), else empty
+
+    // Case-folded open-addressed lookup tables over entries (slot value is entry index + 1, 0 = empty).
+    // Built once by LoadFromFile; stemSlots keys on the name up to the first '.'.
+    std::vector<uint32_t> nameSlots;
+    std::vector<uint32_t> stemSlots;
+
+    // Seek indexes of large compressed entries, filled in by the first full decode of each entry.
+    struct SeekIndexStore {
+        std::mutex mutex;
+        std::unordered_map<uint32_t, std::shared_ptr<const LzssSeekIndex>> byEntry;
+    };
+    std::shared_ptr<SeekIndexStore> seekIndexes;
 
     static bool LoadFromFile(const std::filesystem::path& filePath, BsaArchive& out, std::wstring* err);
+    // Builds lookup tables and runtime state once file and entries are set (LoadFromFile and the sidecar loader).
+    void FinalizeLoad();
+    void BuildNameIndex();
+
+    // Decodes every entry on a worker pool (bypassing the decoded-entry cache) and fills entryMeta.
+    void ComputeEntryMeta(size_t workers = 0);
+    const BsaEntryMeta* MetaFor(const BsaEntry& entry) const;
     const BsaEntry* FindEntryCaseInsensitive(std::string_view name) const;
+    // First entry whose stem matches; when ext is given (e.g. ".BSI") the name must equal stem + ext.
+    const BsaEntry* FindEntryByStem(std::string_view stem, std::string_view ext = {}) const;
     bool ReadEntryData(const BsaEntry& entry, std::vector<uint8_t>& outBytes, std::wstring* err) const;
 
+    // Decoded payload shared with BsaEntryCache; compressed entries are only decoded on a cache miss.
+    BsaPayload ReadEntryShared(const BsaEntry& entry, std::wstring* err) const;
+
+    // Zero-copy read: uncompressed entries are returned as a view into the mapped archive,
+    // compressed entries come from the decoded-entry cache and hold keeps them alive.
+    bool ReadEntryView(const BsaEntry& entry, std::span<const uint8_t>& outView, BsaPayload& hold, std::wstring* err) const;
+
+    // Same, but compressed entries are decoded into buffer without touching the decoded-entry cache (bulk passes
+    // such as extraction would otherwise evict what the viewers keep there).
+    bool ReadEntryUncached(const BsaEntry& entry, std::span<const uint8_t>& outView, std::vector<uint8_t>& buffer, std::wstring* err) const;
+
+    // Decoded bytes [offset, offset + length) of an entry, clamped to its end. Compressed entries are served from
+    // the decoded-entry cache, else by resuming from the nearest seek checkpoint, else by one full decode
+    // (which builds the checkpoints for next time).
+    bool ReadEntryRange(const BsaEntry& entry, size_t offset, size_t length, std::vector<uint8_t>& outBytes, std::wstring* err) const;
+    std::shared_ptr<const LzssSeekIndex> FindSeekIndex(const BsaEntry& entry) const;
+
+    // Packed payload bytes exactly as stored in the archive (empty if the entry is out of bounds).
+    std::span<const uint8_t> PayloadView(const BsaEntry& entry) const;
+
+    const uint8_t* Data() const { return file ? file->Data() : nullptr; }
+    size_t Size() const { return file ? file->Size() : 0; }
+
     // Tools/bsatool-compatible LZSS stream decode (used by pre-Morrowind BSA payloads).
-    static bool DecompressLzss(const uint8_t* data, size_t size, std::vector<uint8_t>& outBytes, std::wstring* err);
+    // sizeHint pre-sizes the output when the decoded size is known; output is capped at 64x the input (max 64 MB).
+    // seekIndex, when given, receives checkpoints every seekIndex->interval decoded bytes.
+    static bool DecompressLzss(const uint8_t* data, size_t size, std::vector<uint8_t>& outBytes, std::wstring* err, size_t sizeHint = 0, LzssSeekIndex* seekIndex = nullptr);
+    // Decodes output bytes [from, to) into out by resuming at checkpoint cp (cp.outPos <= from); produced may be
+    // short if the stream ends first.
+    static bool DecompressLzssRange(const uint8_t* data, size_t size, const LzssCheckpoint& cp, size_t from, size_t to, uint8_t* out, size_t& produced, std::wstring* err);
+    // Same decode into a caller-owned buffer; fails if the output would not fit in outCapacity.
+    static bool DecompressLzssInto(const uint8_t* data, size_t size, uint8_t* out, size_t outCapacity, size_t& outSize, std::wstring* err);
+    // Encoder for the same stream format. maxChain bounds the hash-chain candidates tried per position (speed vs ratio).
+    static void CompressLzss(const uint8_t* data, size_t size, std::vector<uint8_t>& outBytes, size_t maxChain = 64);
 };
 
 struct FlcFile {
@@ -0,0 +1,134 @@
+#include "pch.h"
+#include "BsaEntryCache.h"
+
+namespace battlespire {
+
+BsaEntryCache& BsaEntryCache::Instance() {
+    static BsaEntryCache cache;
+    return cache;
+}
+
+BsaPayload BsaEntryCache::Find(uint32_t archiveId, uint32_t entryIndex) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_map.find(MakeKey(archiveId, entryIndex));
+    if (it == m_map.end()) {
+        m_misses++;
+        return nullptr;
+    }
+    m_hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->payload;
+}
+
+BsaPayload BsaEntryCache::FindByContent(uint32_t archiveId, uint32_t entryIndex, uint64_t contentHash, size_t size) {
+    if (!contentHash) return nullptr;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_byContent.find(contentHash);
+    if (it == m_byContent.end() || it->second.payload->size() != size) return nullptr;
+
+    BsaPayload payload = it->second.payload;
+    const uint64_t key = MakeKey(archiveId, entryIndex);
+    if (m_map.find(key) == m_map.end()) LinkLocked(key, payload, contentHash);
+    m_contentHits++;
+    return payload;
+}
+
+BsaPayload BsaEntryCache::Insert(uint32_t archiveId, uint32_t entryIndex, BsaPayload payload, uint64_t contentHash) {
+    if (!payload) return payload;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (payload->size() > m_budget) return payload;
+
+    const uint64_t key = MakeKey(archiveId, entryIndex);
+    auto it = m_map.find(key);
+    if (it != m_map.end()) {
+        // Another thread decoded the same entry first; keep one copy.
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return it->second->payload;
+    }
+
+    if (contentHash) {
+        auto ct = m_byContent.find(contentHash);
+        if (ct != m_byContent.end()) {
+            if (ct->second.payload->size() == payload->size()) payload = ct->second.payload;
+            else contentHash = 0;   // hash collision: keep this one unshared
+        }
+    }
+    LinkLocked(key, payload, contentHash);
+    EvictToBudgetLocked();
+    return payload;
+}
+
+void BsaEntryCache::LinkLocked(uint64_t key, BsaPayload payload, uint64_t contentHash) {
+    const size_t size = payload->size();
+    if (contentHash) {
+        auto& shared = m_byContent[contentHash];
+        if (shared.refs++ == 0) {
+            shared.payload = payload;
+            m_bytes += size;
+        } else {
+            m_sharedBytes += size;
+        }
+    } else {
+        m_bytes += size;
+    }
+    m_lru.push_front(Node{ key, std::move(payload), contentHash });
+    m_map.emplace(key, m_lru.begin());
+}
+
+void BsaEntryCache::UnlinkLocked(const Node& node) {
+    const size_t size = node.payload->size();
+    if (!node.contentHash) {
+        m_bytes -= size;
+        return;
+    }
+    auto it = m_byContent.find(node.contentHash);
+    if (it == m_byContent.end()) return;
+    if (--it->second.refs == 0) {
+        m_bytes -= size;
+        m_byContent.erase(it);
+    } else {
+        m_sharedBytes -= size;
+    }
+}
+
+void BsaEntryCache::EvictToBudgetLocked() {
+    while (m_bytes > m_budget && !m_lru.empty()) {
+        Node& victim = m_lru.back();
+        UnlinkLocked(victim);
+        m_map.erase(victim.key);
+        m_lru.pop_back();
+        m_evictions++;
+    }
+}
+
+void BsaEntryCache::SetByteBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = bytes;
+    EvictToBudgetLocked();
+}
+
+void BsaEntryCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_map.clear();
+    m_byContent.clear();
+    m_bytes = 0;
+    m_sharedBytes = 0;
+}
+
+BsaCacheStats BsaEntryCache::Stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    BsaCacheStats s;
+    s.hits = m_hits;
+    s.misses = m_misses;
+    s.evictions = m_evictions;
+    s.entries = m_map.size();
+    s.bytes = m_bytes;
+    s.byteBudget = m_budget;
+    s.contentHits = m_contentHits;
+    s.sharedBytes = m_sharedBytes;
+    return s;
+}
+
+} // namespace battlespire
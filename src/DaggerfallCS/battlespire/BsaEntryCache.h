@@ -0,0 +1,70 @@
+#pragma once
+#include "../pch.h"
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace battlespire {
+
+using BsaPayload = std::shared_ptr<const std::vector<uint8_t>>;
+
+struct BsaCacheStats {
+    uint64_t hits{};
+    uint64_t misses{};
+    uint64_t evictions{};
+    size_t entries{};
+    size_t bytes{};
+    size_t byteBudget{};
+    uint64_t contentHits{};   // misses served by an identical payload cached under another key (no decode)
+    size_t sharedBytes{};     // bytes not held twice because identical payloads share one buffer
+};
+
+// Process-wide LRU cache of decoded BSA payloads keyed by (archive cache id, entry index).
+// Payloads are shared and immutable, so a returned pointer stays valid after eviction. Entries inserted with a
+// content hash share one buffer with every other cached entry of the same content, and count once against the budget.
+class BsaEntryCache {
+public:
+    static constexpr size_t kDefaultByteBudget = 96u * 1024u * 1024u;
+
+    static BsaEntryCache& Instance();
+
+    BsaPayload Find(uint32_t archiveId, uint32_t entryIndex);
+    // On a key miss: the payload of any cached entry with this content, filed under the key as well.
+    BsaPayload FindByContent(uint32_t archiveId, uint32_t entryIndex, uint64_t contentHash, size_t size);
+    // contentHash 0 = unknown. Returns the payload now cached for the key (an existing identical one if shared).
+    BsaPayload Insert(uint32_t archiveId, uint32_t entryIndex, BsaPayload payload, uint64_t contentHash = 0);
+
+    void SetByteBudget(size_t bytes);
+    void Clear();
+    BsaCacheStats Stats() const;
+
+private:
+    struct Node {
+        uint64_t key{};
+        BsaPayload payload;
+        uint64_t contentHash{};
+    };
+    struct SharedContent {
+        BsaPayload payload;
+        uint32_t refs{};
+    };
+
+    static uint64_t MakeKey(uint32_t archiveId, uint32_t entryIndex) { return (uint64_t(archiveId) << 32) | entryIndex; }
+    void EvictToBudgetLocked();
+    void LinkLocked(uint64_t key, BsaPayload payload, uint64_t contentHash);
+    void UnlinkLocked(const Node& node);
+
+    mutable std::mutex m_mutex;
+    std::list<Node> m_lru;   // front = most recently used
+    std::unordered_map<uint64_t, std::list<Node>::iterator> m_map;
+    std::unordered_map<uint64_t, SharedContent> m_byContent;
+    size_t m_bytes{};
+    size_t m_budget{ kDefaultByteBudget };
+    uint64_t m_hits{};
+    uint64_t m_misses{};
+    uint64_t m_evictions{};
+    uint64_t m_contentHits{};
+    size_t m_sharedBytes{};
+};
+
+} // namespace battlespire
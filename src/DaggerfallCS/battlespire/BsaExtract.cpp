@@ -0,0 +1,139 @@
+#include "pch.h"
+#include "BsaExtract.h"
+#include "../util/Parallel.h"
+#include "../util/WinUtil.h"
+#include <condition_variable>
+#include <mutex>
+
+namespace battlespire {
+
+// Admits new work only while the decoded bytes held by workers fit the budget. Bytes are reserved before an
+// entry is decoded; a single entry larger than the budget still runs (alone), so extraction never stalls.
+class InFlightBudget {
+public:
+    explicit InFlightBudget(size_t budget) : m_budget(budget) {}
+
+    void Reserve(size_t bytes) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&] { return m_inUse == 0 || bytes <= m_budget - std::min(m_inUse, m_budget); });
+        m_inUse += bytes;
+    }
+    void Release(size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_inUse -= std::min(bytes, m_inUse);
+        }
+        m_cv.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    size_t m_budget{};
+    size_t m_inUse{};
+};
+
+// Decoded bytes an entry will hold while it is written: the sidecar size when known, else a typical LZSS ratio.
+static size_t DecodedBytesEstimate(const BsaArchive& archive, const BsaEntry& entry) {
+    if ((entry.compressionFlag & 0x0001u) == 0) return 0;   // written straight from the mapped archive
+    if (const BsaEntryMeta* meta = archive.MetaFor(entry)) return meta->decodedSize;
+    return size_t(entry.packedSize) * 4;
+}
+
+std::wstring BsaExtractFileName(const BsaEntry& entry, size_t index) {
+    std::wstring name = winutil::WidenUtf8(entry.name);
+    if (name.empty()) name = L"entry_" + std::to_wstring(index);
+    for (auto& c : name) {
+        if (c == L'/' || c == L'\\' || c == L':' || c == L'*' || c == L'?' || c == L'"' || c == L'<' || c == L'>' || c == L'|') c = L'_';
+    }
+    return name;
+}
+
+static bool WriteFileBytes(const std::filesystem::path& path, std::span<const uint8_t> bytes) {
+    std::ofstream f(path, std::ios::binary);
+    if (!f) return false;
+    if (!bytes.empty()) f.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    return f.good();
+}
+
+bool ExtractBsaArchive(const BsaArchive& archive, const std::filesystem::path& outDir, const BsaExtractOptions& options,
+                       const std::atomic_bool* cancel, const BsaExtractProgressFn& progress, BsaExtractResult& result, std::wstring* err) {
+    result = {};
+    result.outDir = outDir;
+    result.total = archive.entries.size();
+
+    std::error_code ec;
+    std::filesystem::create_directories(outDir, ec);
+    if (ec) {
+        if (err) *err = L"Failed to create output folder: " + outDir.wstring();
+        return false;
+    }
+
+    // Sequential extraction overwrote earlier entries with later ones of the same name (and the file system
+    // kept the first spelling), so only the last entry per case-folded name is written, under the first name.
+    // prevSame chains each entry to the previous one of its name, for when the last cannot be read.
+    const size_t count = archive.entries.size();
+    std::vector<std::wstring> names(count);
+    std::vector<size_t> writeAs(count, (size_t)-1);
+    std::vector<size_t> prevSame(count, (size_t)-1);
+    {
+        std::unordered_map<std::wstring, size_t> firstByFolded;
+        std::vector<size_t> lastFor(count);
+        for (size_t i = 0; i < count; ++i) {
+            names[i] = BsaExtractFileName(archive.entries[i], i);
+            std::wstring folded = names[i];
+            for (auto& c : folded) c = (wchar_t)towupper(c);
+            auto [it, inserted] = firstByFolded.emplace(std::move(folded), i);
+            if (!inserted) prevSame[i] = lastFor[it->second];
+            lastFor[it->second] = i;
+        }
+        for (const auto& kv : firstByFolded) writeAs[lastFor[kv.second]] = kv.second;
+    }
+
+    InFlightBudget budget(options.maxInFlightBytes ? options.maxInFlightBytes : SIZE_MAX);
+    std::atomic<size_t> done{ 0 };
+    std::atomic<size_t> okCount{ 0 };
+    std::atomic<size_t> failCount{ 0 };
+    std::atomic<size_t> fallbackCount{ 0 };
+    std::atomic_bool stopped{ false };
+
+    winutil::ParallelFor(count, options.workerCount, [&](size_t i, size_t) {
+        if (cancel && cancel->load()) {
+            stopped.store(true);
+            return;
+        }
+
+        bool ok = true;
+        if (writeAs[i] != (size_t)-1) {
+            // If this entry cannot be read, the file still gets the last earlier entry of the name that can; the
+            // entry itself counts as failed.
+            for (size_t e = i; e != (size_t)-1; e = prevSame[e]) {
+                const size_t reserved = DecodedBytesEstimate(archive, archive.entries[e]);
+                budget.Reserve(reserved);
+
+                std::vector<uint8_t> decoded;
+                std::span<const uint8_t> bytes;
+                std::wstring derr;
+                const bool read = archive.ReadEntryUncached(archive.entries[e], bytes, decoded, &derr);
+                const bool written = read && WriteFileBytes(outDir / names[writeAs[i]], bytes);
+                if (e == i) ok = written;
+                else if (written) fallbackCount.fetch_add(1);
+                decoded = {};
+                budget.Release(reserved);
+                if (read) break;
+            }
+        }
+
+        (ok ? okCount : failCount).fetch_add(1);
+        const size_t n = done.fetch_add(1) + 1;
+        if (progress) progress(n, count);
+    });
+
+    result.okCount = okCount.load();
+    result.failCount = failCount.load();
+    result.fallbackCount = fallbackCount.load();
+    result.cancelled = stopped.load();
+    return true;
+}
+
+} // namespace battlespire
@@ -0,0 +1,35 @@
+#pragma once
+#include "../pch.h"
+#include "BattlespireFormats.h"
+#include <functional>
+
+namespace battlespire {
+
+struct BsaExtractOptions {
+    size_t workerCount{};                              // 0 = one per hardware thread
+    size_t maxInFlightBytes{ 64u * 1024u * 1024u };    // decoded bytes held by workers before new entries wait
+};
+
+struct BsaExtractResult {
+    std::filesystem::path outDir;
+    size_t total{};
+    size_t okCount{};
+    size_t failCount{};
+    size_t fallbackCount{};   // files written from an earlier entry of the same name because the last one failed
+    bool cancelled{ false };
+};
+
+// Called from worker threads after each entry; done counts entries finished so far (ok or failed).
+using BsaExtractProgressFn = std::function<void(size_t done, size_t total)>;
+
+// Output file name used for an entry: the entry name with path/reserved characters replaced, or entry_<index>.
+std::wstring BsaExtractFileName(const BsaEntry& entry, size_t index);
+
+// Writes every entry of the archive to outDir using a worker pool. Output matches a sequential extraction in
+// entry order: when several entries map to the same file name the last one that can be read wins. cancel may
+// be null.
+// Returns false only if the output folder could not be created.
+bool ExtractBsaArchive(const BsaArchive& archive, const std::filesystem::path& outDir, const BsaExtractOptions& options,
+                       const std::atomic_bool* cancel, const BsaExtractProgressFn& progress, BsaExtractResult& result, std::wstring* err);
+
+} // namespace battlespire
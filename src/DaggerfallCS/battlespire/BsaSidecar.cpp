@@ -0,0 +1,203 @@
+#include "pch.h"
+#include "BsaSidecar.h"
+#include "../util/Hash64.h"
+
+namespace battlespire {
+
+static constexpr char kMagic[8] = { 'D', 'F', 'B', 'S', 'A', 'I', 'D', 'X' };
+static constexpr uint32_t kVersion = 1;
+
+static uint16_t ReadU16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (uint16_t(p[1]) << 8));
+}
+
+static void WriteLe(std::vector<uint8_t>& out, uint64_t v, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>((v >> (8 * i)) & 0xFF));
+}
+
+struct SidecarReader {
+    const uint8_t* p{};
+    const uint8_t* end{};
+    bool ok{ true };
+
+    uint64_t Read(size_t bytes) {
+        if (!ok || size_t(end - p) < bytes) { ok = false; return 0; }
+        uint64_t v = 0;
+        for (size_t i = 0; i < bytes; ++i) v |= uint64_t(p[i]) << (8 * i);
+        p += bytes;
+        return v;
+    }
+    std::string ReadString() {
+        size_t n = static_cast<size_t>(Read(2));
+        if (!ok || size_t(end - p) < n) { ok = false; return {}; }
+        std::string s(reinterpret_cast<const char*>(p), n);
+        p += n;
+        return s;
+    }
+};
+
+// Identity of the archive bytes the sidecar was built from.
+struct ArchiveStamp {
+    uint64_t fileSize{};
+    int64_t mtime{};
+    uint64_t headerHash{};
+};
+
+static bool StampArchive(const std::filesystem::path& archivePath, const winutil::MappedFile& file, ArchiveStamp& out) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(archivePath, ec);
+    if (ec || file.Size() < 4) return false;
+
+    // Header (count + type) and the footer it implies; the footer holds the whole entry table.
+    const uint16_t count = ReadU16(file.Data());
+    const uint16_t type = ReadU16(file.Data() + 2);
+    const size_t entrySize = (type == 0x100) ? 18 : (type == 0x200) ? 8 : 6;
+    const size_t footerBytes = std::min(file.Size() - 4, size_t(count) * entrySize);
+
+    out.fileSize = file.Size();
+    out.mtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    out.headerHash = winutil::Hash64(file.Data() + file.Size() - footerBytes, footerBytes, winutil::Hash64(file.Data(), 4));
+    return true;
+}
+
+std::filesystem::path BsaSidecarPath(const std::filesystem::path& cacheDir, const std::filesystem::path& archivePath) {
+    std::error_code ec;
+    std::wstring full = std::filesystem::absolute(archivePath, ec).wstring();
+    for (auto& c : full) c = (wchar_t)towupper(c);
+
+    wchar_t suffix[32]{};
+    swprintf_s(suffix, L"-%016llX.bsaidx", (unsigned long long)winutil::Hash64(full.data(), full.size() * sizeof(wchar_t)));
+    return cacheDir / (archivePath.stem().wstring() + suffix);
+}
+
+bool LoadBsaSidecar(const std::filesystem::path& cacheDir, const std::filesystem::path& archivePath, BsaArchive& out) {
+    out = {};
+
+    std::ifstream f(BsaSidecarPath(cacheDir, archivePath), std::ios::binary);
+    if (!f) return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    if (bytes.size() < sizeof(kMagic) + 8 || memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) return false;
+
+    // Trailing hash guards against truncated or partially written sidecars.
+    const size_t bodySize = bytes.size() - 8;
+    SidecarReader tail{ bytes.data() + bodySize, bytes.data() + bytes.size() };
+    if (tail.Read(8) != winutil::Hash64(bytes.data(), bodySize)) return false;
+
+    SidecarReader r{ bytes.data() + sizeof(kMagic), bytes.data() + bodySize };
+    if (r.Read(4) != kVersion) return false;
+
+    ArchiveStamp stored;
+    stored.fileSize = r.Read(8);
+    stored.mtime = static_cast<int64_t>(r.Read(8));
+    stored.headerHash = r.Read(8);
+    if (!r.ok) return false;
+
+    std::wstring err;
+    auto file = winutil::MappedFile::Open(archivePath, &err);
+    ArchiveStamp current;
+    if (!file || !StampArchive(archivePath, *file, current)) return false;
+    if (current.fileSize != stored.fileSize || current.mtime != stored.mtime || current.headerHash != stored.headerHash) return false;
+
+    BsaArchive a;
+    a.sourcePath = archivePath;
+    a.file = std::move(file);
+    a.recordCount = static_cast<uint16_t>(r.Read(2));
+    a.recordType = static_cast<uint16_t>(r.Read(2));
+    const size_t entryCount = static_cast<size_t>(r.Read(4));
+    const bool hasMeta = r.Read(1) != 0;
+    if (!r.ok || entryCount != a.recordCount) return false;
+
+    a.entries.resize(entryCount);
+    for (auto& e : a.entries) {
+        e.name = r.ReadString();
+        e.offset = static_cast<uint32_t>(r.Read(4));
+        e.packedSize = static_cast<uint32_t>(r.Read(4));
+        e.compressionFlag = static_cast<uint16_t>(r.Read(2));
+        if (!r.ok || e.offset > a.file->Size() || e.packedSize > a.file->Size() - e.offset) return false;
+    }
+    if (hasMeta) {
+        a.entryMeta.resize(entryCount);
+        for (auto& m : a.entryMeta) {
+            m.decodedSize = static_cast<uint32_t>(r.Read(4));
+            m.kind = static_cast<BsaContentKind>(r.Read(1));
+            m.contentHash = r.Read(8);
+        }
+    }
+    if (!r.ok || r.p != r.end) return false;
+
+    a.FinalizeLoad();
+    out = std::move(a);
+    return true;
+}
+
+bool SaveBsaSidecar(const std::filesystem::path& cacheDir, const BsaArchive& archive, std::wstring* err) {
+    ArchiveStamp stamp;
+    if (!archive.file || !StampArchive(archive.sourcePath, *archive.file, stamp)) {
+        if (err) *err = L"Archive is not open.";
+        return false;
+    }
+
+    std::vector<uint8_t> out(kMagic, kMagic + sizeof(kMagic));
+    WriteLe(out, kVersion, 4);
+    WriteLe(out, stamp.fileSize, 8);
+    WriteLe(out, static_cast<uint64_t>(stamp.mtime), 8);
+    WriteLe(out, stamp.headerHash, 8);
+    WriteLe(out, archive.recordCount, 2);
+    WriteLe(out, archive.recordType, 2);
+    WriteLe(out, archive.entries.size(), 4);
+    const bool hasMeta = archive.entryMeta.size() == archive.entries.size();
+    WriteLe(out, hasMeta ? 1 : 0, 1);
+
+    for (const auto& e : archive.entries) {
+        const size_t n = std::min<size_t>(e.name.size(), 0xFFFF);
+        WriteLe(out, n, 2);
+        out.insert(out.end(), e.name.begin(), e.name.begin() + n);
+        WriteLe(out, e.offset, 4);
+        WriteLe(out, e.packedSize, 4);
+        WriteLe(out, e.compressionFlag, 2);
+    }
+    if (hasMeta) {
+        for (const auto& m : archive.entryMeta) {
+            WriteLe(out, m.decodedSize, 4);
+            WriteLe(out, static_cast<uint8_t>(m.kind), 1);
+            WriteLe(out, m.contentHash, 8);
+        }
+    }
+    WriteLe(out, winutil::Hash64(out.data(), out.size()), 8);
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    const auto finalPath = BsaSidecarPath(cacheDir, archive.sourcePath);
+    auto tmpPath = finalPath;
+    tmpPath += L".tmp";
+    {
+        std::ofstream f(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            if (err) *err = L"Failed to write " + tmpPath.wstring();
+            return false;
+        }
+        f.write(reinterpret_cast<const char*>(out.data()), (std::streamsize)out.size());
+        if (!f.good()) {
+            if (err) *err = L"Failed to write " + tmpPath.wstring();
+            return false;
+        }
+    }
+    std::filesystem::rename(tmpPath, finalPath, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        if (err) *err = L"Failed to replace " + finalPath.wstring();
+        return false;
+    }
+    return true;
+}
+
+bool OpenBsaArchive(const std::filesystem::path& archivePath, const std::filesystem::path& cacheDir, BsaArchive& out, bool* fromSidecar, std::wstring* err) {
+    if (fromSidecar) *fromSidecar = false;
+    if (!cacheDir.empty() && LoadBsaSidecar(cacheDir, archivePath, out)) {
+        if (fromSidecar) *fromSidecar = true;
+        return true;
+    }
+    return BsaArchive::LoadFromFile(archivePath, out, err);
+}
+
+} // namespace battlespire
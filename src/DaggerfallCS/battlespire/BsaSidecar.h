@@ -0,0 +1,19 @@
+#pragma once
+#include "../pch.h"
+#include "BattlespireFormats.h"
+
+namespace battlespire {
+
+// Versioned per-archive cache of the parsed entry table and entry metadata (decoded size, content kind,
+// content hash), so re-opening an install skips footer parsing and content sniffing. Stored as
+// <cacheDir>/<archive stem>-<path hash>.bsaidx and only trusted when the archive's size, mtime and a hash of
+// its header and footer bytes still match.
+std::filesystem::path BsaSidecarPath(const std::filesystem::path& cacheDir, const std::filesystem::path& archivePath);
+
+bool LoadBsaSidecar(const std::filesystem::path& cacheDir, const std::filesystem::path& archivePath, BsaArchive& out);
+bool SaveBsaSidecar(const std::filesystem::path& cacheDir, const BsaArchive& archive, std::wstring* err);
+
+// Opens through a valid sidecar when there is one, otherwise parses the archive. fromSidecar may be null.
+bool OpenBsaArchive(const std::filesystem::path& archivePath, const std::filesystem::path& cacheDir, BsaArchive& out, bool* fromSidecar, std::wstring* err);
+
+} // namespace battlespire
@@ -0,0 +1,218 @@
+#include "pch.h"
+#include "BsaWriter.h"
+#include "AssetVfs.h"
+#include "../util/Parallel.h"
+#include "../util/WinUtil.h"
+#include <charconv>
+
+namespace battlespire {
+
+static void WriteLe(std::vector<uint8_t>& out, uint32_t v, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out.push_back(static_cast<uint8_t>((v >> (8 * i)) & 0xFF));
+}
+
+static bool ParseRecordId(std::string_view name, uint16_t& id) {
+    if (name.size() < 5 || name.substr(0, 4) != "REC_") return false;
+    unsigned v = 0;
+    auto [ptr, ec] = std::from_chars(name.data() + 4, name.data() + name.size(), v);
+    if (ec != std::errc() || ptr != name.data() + name.size() || v > 0xFFFF) return false;
+    id = static_cast<uint16_t>(v);
+    return true;
+}
+
+static std::wstring EntryError(const wchar_t* what, const std::string& name) {
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"%s: %s", what, winutil::WidenUtf8(name).c_str());
+    return buf;
+}
+
+bool WriteBsaArchive(const std::filesystem::path& outPath, const std::vector<BsaWriteEntry>& entries, const BsaWriteOptions& options,
+                     BsaWriteResult* result, std::wstring* err) {
+    if (result) *result = {};
+    if (options.recordType != 0x100 && options.recordType != 0x200) {
+        if (err) *err = L"Only 0x100 and 0x200 BSA layouts can be written.";
+        return false;
+    }
+    if (entries.size() > 0xFFFF) {
+        if (err) *err = L"Too many entries for a BSA (max 65535).";
+        return false;
+    }
+
+    const size_t count = entries.size();
+    std::vector<uint16_t> recordIds(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto& e = entries[i];
+        if (options.recordType == 0x100 && e.name.size() > 12) {
+            if (err) *err = EntryError(L"Entry name longer than 12 characters", e.name);
+            return false;
+        }
+        if (options.recordType == 0x200 && !ParseRecordId(e.name, recordIds[i])) {
+            if (err) *err = EntryError(L"Record name is not REC_<id>", e.name);
+            return false;
+        }
+    }
+
+    // Compress on the pool; payloads[i] stays empty for entries stored as-is.
+    std::vector<std::vector<uint8_t>> payloads(count);
+    std::atomic<size_t> failedIndex{ SIZE_MAX };
+    winutil::ParallelFor(count, options.workerCount, [&](size_t i, size_t) {
+        const auto& e = entries[i];
+        if (!e.packed.empty() || (e.compressionFlag & 0x0001u) == 0 || e.data.empty()) return;
+        if (failedIndex.load() != SIZE_MAX) return;
+
+        BsaArchive::CompressLzss(e.data.data(), e.data.size(), payloads[i], options.maxChain);
+        if (options.verify) {
+            std::vector<uint8_t> check;
+            if (!BsaArchive::DecompressLzss(payloads[i].data(), payloads[i].size(), check, nullptr, e.data.size()) || check != e.data) {
+                size_t none = SIZE_MAX;
+                failedIndex.compare_exchange_strong(none, i);
+            }
+        }
+    });
+    if (failedIndex.load() != SIZE_MAX) {
+        if (err) *err = EntryError(L"LZSS round trip failed for entry", entries[failedIndex.load()].name);
+        return false;
+    }
+
+    auto payloadOf = [&](size_t i) -> std::span<const uint8_t> {
+        const auto& e = entries[i];
+        if (!e.packed.empty()) return e.packed;
+        if ((e.compressionFlag & 0x0001u) != 0 && !e.data.empty()) return payloads[i];
+        return e.data;
+    };
+
+    uint64_t offset = 4;
+    for (size_t i = 0; i < count; ++i) offset += payloadOf(i).size();
+    if (offset + uint64_t(count) * 18 > 0xFFFFFFFFull) {
+        if (err) *err = L"BSA would exceed 4 GB.";
+        return false;
+    }
+
+    std::vector<uint8_t> header;
+    WriteLe(header, static_cast<uint32_t>(count), 2);
+    WriteLe(header, options.recordType, 2);
+
+    std::vector<uint8_t> footer;
+    footer.reserve(count * (options.recordType == 0x100 ? 18 : 8));
+    for (size_t i = 0; i < count; ++i) {
+        const auto& e = entries[i];
+        const uint32_t size = static_cast<uint32_t>(payloadOf(i).size());
+        if (options.recordType == 0x100) {
+            char nameBuf[12]{};
+            memcpy(nameBuf, e.name.data(), e.name.size());
+            footer.insert(footer.end(), nameBuf, nameBuf + 12);
+            WriteLe(footer, e.compressionFlag, 2);
+            WriteLe(footer, size, 4);
+        } else {
+            WriteLe(footer, e.compressionFlag, 2);
+            WriteLe(footer, recordIds[i], 2);
+            WriteLe(footer, size, 4);
+        }
+    }
+
+    std::filesystem::path tmp = outPath;
+    tmp += L".tmp";
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            if (err) *err = L"Failed to create " + tmp.wstring();
+            return false;
+        }
+        f.write(reinterpret_cast<const char*>(header.data()), (std::streamsize)header.size());
+        for (size_t i = 0; i < count && f; ++i) {
+            const auto bytes = payloadOf(i);
+            if (!bytes.empty()) f.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+        }
+        if (!footer.empty()) f.write(reinterpret_cast<const char*>(footer.data()), (std::streamsize)footer.size());
+        if (!f.good()) {
+            f.close();
+            std::error_code ec;
+            std::filesystem::remove(tmp, ec);
+            if (err) *err = L"Failed to write " + tmp.wstring();
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, outPath, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        if (err) *err = L"Failed to replace " + outPath.wstring();
+        return false;
+    }
+
+    if (result) {
+        for (size_t i = 0; i < count; ++i) {
+            const auto& e = entries[i];
+            if (!e.packed.empty()) {
+                result->passthroughCount++;
+            } else if ((e.compressionFlag & 0x0001u) != 0 && !e.data.empty()) {
+                result->compressedCount++;
+                result->decodedBytes += e.data.size();
+                result->packedBytes += payloads[i].size();
+            }
+        }
+        result->fileBytes = offset + footer.size();
+    }
+    return true;
+}
+
+bool RepackBsaArchive(const BsaArchive& source, const std::filesystem::path& overrideDir, const std::filesystem::path& outPath,
+                      bool recompressAll, const BsaWriteOptions& options, BsaWriteResult* result, size_t* overriddenCount, std::wstring* err) {
+    if (overriddenCount) *overriddenCount = 0;
+
+    AssetVfs overrides;
+    if (!overrideDir.empty()) {
+        overrides.MountDirectory(overrideDir, 0);
+        overrides.BuildIndex();
+    }
+
+    const size_t count = source.entries.size();
+    std::vector<BsaWriteEntry> out(count);
+    std::vector<const AssetLocation*> replaced(count);
+    for (size_t i = 0; i < count; ++i) {
+        const auto& e = source.entries[i];
+        out[i].name = e.name;
+        out[i].compressionFlag = e.compressionFlag;
+        replaced[i] = overrides.Find(e.name);
+    }
+
+    // Load override files and (for recompressAll) decode the originals on the pool; anything that fails to
+    // decode is carried over packed.
+    std::atomic<size_t> failedIndex{ SIZE_MAX };
+    winutil::ParallelFor(count, options.workerCount, [&](size_t i, size_t) {
+        auto& w = out[i];
+        if (replaced[i]) {
+            if (!overrides.Read(*replaced[i], w.data, nullptr)) {
+                size_t none = SIZE_MAX;
+                failedIndex.compare_exchange_strong(none, i);
+            }
+            return;
+        }
+        // Decoded outside the shared entry cache, which a full repack would otherwise flush. A compressed entry
+        // handed back as its raw payload did not decode.
+        const auto& e = source.entries[i];
+        const bool compressed = (e.compressionFlag & 0x0001u) != 0;
+        std::span<const uint8_t> view;
+        if (!recompressAll || !source.ReadEntryUncached(e, view, w.data, nullptr) || (compressed && view.data() != w.data.data())) {
+            w.data.clear();
+            w.packed = source.PayloadView(e);
+            return;
+        }
+        if (!compressed) w.data.assign(view.begin(), view.end());
+    });
+    if (failedIndex.load() != SIZE_MAX) {
+        if (err) *err = EntryError(L"Failed to read override file", out[failedIndex.load()].name);
+        return false;
+    }
+
+    if (overriddenCount) {
+        for (const auto* r : replaced) if (r) (*overriddenCount)++;
+    }
+
+    BsaWriteOptions writeOptions = options;
+    writeOptions.recordType = source.recordType;
+    return WriteBsaArchive(outPath, out, writeOptions, result, err);
+}
+
+} // namespace battlespire
@@ -0,0 +1,40 @@
+#pragma once
+#include "../pch.h"
+#include "BattlespireFormats.h"
+
+namespace battlespire {
+
+struct BsaWriteEntry {
+    std::string name;                          // 0x100: up to 12 characters; 0x200: "REC_<id>" as produced by the reader
+    uint16_t compressionFlag{};                // bit 0 set: data is LZSS-compressed on write
+    std::vector<uint8_t> data;                 // decoded content
+    std::span<const uint8_t> packed;           // when non-empty, stored verbatim with compressionFlag and data is ignored
+};
+
+struct BsaWriteOptions {
+    uint16_t recordType{ 0x100 };              // 0x100 (named entries) or 0x200 (numbered records)
+    size_t workerCount{};                      // 0 = one per hardware thread
+    size_t maxChain{ 64 };                     // LZSS match finder effort
+    bool verify{ true };                       // decode every freshly compressed entry and compare before writing
+};
+
+struct BsaWriteResult {
+    size_t compressedCount{};
+    size_t passthroughCount{};
+    uint64_t decodedBytes{};                   // input bytes of the entries compressed on this write
+    uint64_t packedBytes{};                    // their compressed size
+    uint64_t fileBytes{};
+};
+
+// Writes a Battlespire BSA: u16 count, u16 type, the payloads back to back, then the footer. Entries are
+// compressed on a worker pool; the file is written to <outPath>.tmp and renamed over outPath on success.
+bool WriteBsaArchive(const std::filesystem::path& outPath, const std::vector<BsaWriteEntry>& entries, const BsaWriteOptions& options,
+                     BsaWriteResult* result, std::wstring* err);
+
+// Rebuilds source with every entry that has a same-named file in overrideDir replaced (recompressed if the
+// original entry was compressed). Untouched entries keep their packed bytes unless recompressAll is set.
+// overrideDir may be empty.
+bool RepackBsaArchive(const BsaArchive& source, const std::filesystem::path& overrideDir, const std::filesystem::path& outPath,
+                      bool recompressAll, const BsaWriteOptions& options, BsaWriteResult* result, size_t* overriddenCount, std::wstring* err);
+
+} // namespace battlespire
@@ -0,0 +1,774 @@
+#include "pch.h"
+#include "Headless.h"
+#include "../arena2/QuestSim.h"
+#include "../arena2/QuestSnapshot.h"
+#include "../arena2/TextRsc.h"
+#include "../arena2/TextRscWriter.h"
+#include "../arena2/TextScan.h"
+#include "../battlespire/BattlespireFormats.h"
+#include "../battlespire/BsaExtract.h"
+#include "../battlespire/BsaWriter.h"
+#include "../util/WinUtil.h"
+#include <chrono>
+
+namespace cli {
+
+static void Print(const std::wstring& s) {
+    static HANDLE out = [] {
+        HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
+        if (!h || h == INVALID_HANDLE_VALUE) {
+            // GUI subsystem: only attached to a console when launched from one.
+            if (AttachConsole(ATTACH_PARENT_PROCESS)) h = GetStdHandle(STD_OUTPUT_HANDLE);
+        }
+        return h;
+    }();
+
+    std::string utf8 = winutil::NarrowUtf8(s + L"\n");
+    if (out && out != INVALID_HANDLE_VALUE) {
+        DWORD written = 0;
+        WriteFile(out, utf8.data(), (DWORD)utf8.size(), &written, nullptr);
+    } else {
+        OutputDebugStringW((s + L"\n").c_str());
+    }
+}
+
+static std::vector<std::filesystem::path> FindBsaFiles(const std::filesystem::path& root) {
+    std::vector<std::filesystem::path> out;
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(root, std::filesystem::directory_options::skip_permission_denied, ec);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        if (!it->is_regular_file(ec)) continue;
+        std::wstring ext = it->path().extension().wstring();
+        for (auto& c : ext) c = (wchar_t)towupper(c);
+        if (ext == L".BSA") out.push_back(it->path());
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// The original byte-at-a-time ring-window decoder, kept as the oracle for the benchmark.
+static bool ReferenceDecompressLzss(const uint8_t* data, size_t size, std::vector<uint8_t>& outBytes) {
+    outBytes.clear();
+    if (!data || size == 0) return true;
+
+    const size_t maxOutBytes = std::min<size_t>(64u * 1024u * 1024u, std::max<size_t>(size * 64u, size + 4096u));
+
+    std::array<uint8_t, 4096> window{};
+    for (size_t i = 0; i < 4078; ++i) window[i] = static_cast<uint8_t>(' ');
+
+    size_t pos = 4078;
+    size_t ip = 0;
+    while (ip < size) {
+        uint8_t flags = data[ip++];
+        for (int bit = 0; bit < 8; ++bit) {
+            if (ip >= size) break;
+            if ((flags >> bit) & 1u) {
+                uint8_t b = data[ip++];
+                outBytes.push_back(b);
+                if (outBytes.size() > maxOutBytes) return false;
+                window[pos] = b;
+                pos = (pos + 1) & 0xFFFu;
+            } else {
+                if (ip + 1 >= size) return false;
+                uint8_t b0 = data[ip++];
+                uint8_t b1 = data[ip++];
+                size_t offset = size_t(b0) | (size_t(b1 & 0xF0u) << 4);
+                size_t length = size_t(b1 & 0x0Fu) + 3;
+                for (size_t k = 0; k < length; ++k) {
+                    uint8_t b = window[(offset + k) & 0xFFFu];
+                    outBytes.push_back(b);
+                    if (outBytes.size() > maxOutBytes) return false;
+                    window[pos] = b;
+                    pos = (pos + 1) & 0xFFFu;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static int CmdBenchLzss(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        Print(L"usage: --bench-lzss <folder> [repeat]");
+        return 2;
+    }
+    const std::filesystem::path root = args[1];
+    int repeat = (args.size() > 2) ? _wtoi(args[2].c_str()) : 5;
+    if (repeat < 1) repeat = 1;
+
+    auto files = FindBsaFiles(root);
+    if (files.empty()) {
+        Print(L"No .BSA files found under " + root.wstring());
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    double refSecTotal = 0.0, newSecTotal = 0.0;
+    uint64_t packedTotal = 0, decodedTotal = 0;
+    size_t entriesTotal = 0, mismatches = 0, rangesChecked = 0;
+
+    std::vector<uint8_t> refOut, newOut;
+    for (const auto& path : files) {
+        battlespire::BsaArchive archive;
+        std::wstring err;
+        if (!battlespire::BsaArchive::LoadFromFile(path, archive, &err)) {
+            Print(path.filename().wstring() + L": " + err);
+            continue;
+        }
+
+        double refSec = 0.0, newSec = 0.0;
+        uint64_t packed = 0, decoded = 0;
+        size_t count = 0;
+        for (const auto& e : archive.entries) {
+            if ((e.compressionFlag & 1u) == 0) continue;
+            auto payload = archive.PayloadView(e);
+            if (payload.empty()) continue;
+
+            const bool refOk = ReferenceDecompressLzss(payload.data(), payload.size(), refOut);
+            std::wstring lzErr;
+            const bool newOk = battlespire::BsaArchive::DecompressLzss(payload.data(), payload.size(), newOut, &lzErr);
+            if (refOk != newOk || (refOk && refOut != newOut)) {
+                mismatches++;
+                Print(L"  MISMATCH " + path.filename().wstring() + L" : " + winutil::WidenUtf8(e.name));
+                continue;
+            }
+            if (!refOk) continue;
+
+            // Ranged reads resumed from seek checkpoints must match slices of the full decode.
+            battlespire::LzssSeekIndex seekIndex;
+            std::vector<uint8_t> indexed;
+            battlespire::BsaArchive::DecompressLzss(payload.data(), payload.size(), indexed, nullptr, 0, &seekIndex);
+            for (size_t c = 1; c < seekIndex.checkpoints.size(); ++c) {
+                const size_t from = seekIndex.checkpoints[c].outPos + seekIndex.interval / 2;
+                const size_t to = std::min(from + 256, refOut.size());
+                if (from >= to) continue;
+                std::vector<uint8_t> part(to - from);
+                size_t produced = 0;
+                rangesChecked++;
+                if (!battlespire::BsaArchive::DecompressLzssRange(payload.data(), payload.size(), seekIndex.checkpoints[c], from, to, part.data(), produced, nullptr)
+                    || produced != part.size() || !std::equal(part.begin(), part.end(), refOut.begin() + from)) {
+                    mismatches++;
+                    Print(L"  RANGE MISMATCH " + path.filename().wstring() + L" : " + winutil::WidenUtf8(e.name));
+                    break;
+                }
+            }
+
+            auto t0 = Clock::now();
+            for (int r = 0; r < repeat; ++r) ReferenceDecompressLzss(payload.data(), payload.size(), refOut);
+            auto t1 = Clock::now();
+            for (int r = 0; r < repeat; ++r) battlespire::BsaArchive::DecompressLzss(payload.data(), payload.size(), newOut, nullptr);
+            auto t2 = Clock::now();
+
+            refSec += std::chrono::duration<double>(t1 - t0).count();
+            newSec += std::chrono::duration<double>(t2 - t1).count();
+            packed += payload.size();
+            decoded += newOut.size();
+            count++;
+        }
+        if (!count) continue;
+
+        const double mb = double(decoded) * repeat / (1024.0 * 1024.0);
+        wchar_t buf[512]{};
+        swprintf_s(buf, L"%-16s %6zu entries %10llu -> %10llu bytes  ref %8.1f MB/s  new %8.1f MB/s",
+                   path.filename().wstring().c_str(), count, (unsigned long long)packed, (unsigned long long)decoded,
+                   refSec > 0 ? mb / refSec : 0.0, newSec > 0 ? mb / newSec : 0.0);
+        Print(buf);
+
+        refSecTotal += refSec;
+        newSecTotal += newSec;
+        packedTotal += packed;
+        decodedTotal += decoded;
+        entriesTotal += count;
+    }
+
+    const double mb = double(decodedTotal) * repeat / (1024.0 * 1024.0);
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"TOTAL %zu compressed entries, %llu -> %llu bytes, x%d: ref %.1f MB/s, new %.1f MB/s (%.2fx), mismatches %zu",
+               entriesTotal, (unsigned long long)packedTotal, (unsigned long long)decodedTotal, repeat,
+               refSecTotal > 0 ? mb / refSecTotal : 0.0, newSecTotal > 0 ? mb / newSecTotal : 0.0,
+               newSecTotal > 0 ? refSecTotal / newSecTotal : 0.0, mismatches);
+    Print(buf);
+    Print(L"Ranged reads from seek checkpoints verified: " + std::to_wstring(rangesChecked));
+    return mismatches ? 1 : 0;
+}
+
+static int CmdExtractBsa(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        Print(L"usage: --extract-bsa <archive.bsa> [outDir]");
+        return 2;
+    }
+    const std::filesystem::path bsaPath = args[1];
+    const std::filesystem::path outDir = (args.size() > 2)
+        ? std::filesystem::path(args[2])
+        : winutil::GetExeDirectory() / (bsaPath.stem().wstring() + L"_extracted");
+
+    battlespire::BsaArchive archive;
+    std::wstring err;
+    if (!battlespire::BsaArchive::LoadFromFile(bsaPath, archive, &err)) {
+        Print(L"Failed to open BSA: " + err);
+        return 1;
+    }
+
+    std::atomic<int> lastDecile{ 0 };
+    auto progress = [&](size_t done, size_t total) {
+        int decile = total ? (int)(done * 10 / total) : 10;
+        int prev = lastDecile.load();
+        while (decile > prev) {
+            if (lastDecile.compare_exchange_weak(prev, decile)) {
+                Print(L"  " + std::to_wstring(done) + L" / " + std::to_wstring(total));
+                break;
+            }
+        }
+    };
+
+    battlespire::BsaExtractResult result;
+    if (!battlespire::ExtractBsaArchive(archive, outDir, battlespire::BsaExtractOptions{}, nullptr, progress, result, &err)) {
+        Print(err);
+        return 1;
+    }
+
+    Print(L"Extracted " + std::to_wstring(result.okCount) + L" entries to " + outDir.wstring());
+    if (result.failCount) Print(L"Failed entries: " + std::to_wstring(result.failCount));
+    if (result.fallbackCount) Print(L"Written from an earlier entry of the same name: " + std::to_wstring(result.fallbackCount));
+    return result.failCount ? 1 : 0;
+}
+
+static int CmdRepackBsa(const std::vector<std::wstring>& args) {
+    if (args.size() < 4) {
+        Print(L"usage: --repack-bsa <source.bsa> <overrideDir|-> <out.bsa> [--recompress]");
+        return 2;
+    }
+    const std::filesystem::path srcPath = args[1];
+    const std::filesystem::path overrideDir = (args[2] == L"-") ? std::filesystem::path() : std::filesystem::path(args[2]);
+    const std::filesystem::path outPath = args[3];
+    const bool recompressAll = args.size() > 4 && args[4] == L"--recompress";
+
+    battlespire::BsaArchive archive;
+    std::wstring err;
+    if (!battlespire::BsaArchive::LoadFromFile(srcPath, archive, &err)) {
+        Print(L"Failed to open BSA: " + err);
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    battlespire::BsaWriteResult result;
+    size_t overridden = 0;
+    if (!battlespire::RepackBsaArchive(archive, overrideDir, outPath, recompressAll, battlespire::BsaWriteOptions{}, &result, &overridden, &err)) {
+        Print(L"Repack failed: " + err);
+        return 1;
+    }
+    const double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    // Read the result back and compare every entry with what was meant to go in.
+    battlespire::BsaArchive written;
+    if (!battlespire::BsaArchive::LoadFromFile(outPath, written, &err) || written.entries.size() != archive.entries.size()) {
+        Print(L"Written archive does not load back: " + err);
+        return 1;
+    }
+    size_t mismatches = 0;
+    for (size_t i = 0; i < archive.entries.size(); ++i) {
+        std::vector<uint8_t> expected, actual;
+        bool fromOverride = false;
+        if (!overrideDir.empty()) {
+            std::ifstream f(overrideDir / winutil::WidenUtf8(archive.entries[i].name), std::ios::binary);
+            if (f) {
+                expected.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+                fromOverride = true;
+            }
+        }
+        if (!fromOverride && !archive.ReadEntryData(archive.entries[i], expected, nullptr)) continue;
+        if (!written.ReadEntryData(written.entries[i], actual, nullptr) || actual != expected) {
+            mismatches++;
+            Print(L"  MISMATCH " + winutil::WidenUtf8(archive.entries[i].name));
+        }
+    }
+
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"Wrote %s: %zu entries (%zu overridden, %zu compressed, %zu copied packed), %llu -> %llu bytes compressed, %llu bytes total in %.2f s, mismatches %zu",
+               outPath.wstring().c_str(), archive.entries.size(), overridden, result.compressedCount, result.passthroughCount,
+               (unsigned long long)result.decodedBytes, (unsigned long long)result.packedBytes, (unsigned long long)result.fileBytes, sec, mismatches);
+    Print(buf);
+    return mismatches ? 1 : 0;
+}
+
+static std::vector<std::filesystem::path> FindTextDbFiles(const std::filesystem::path& root) {
+    std::vector<std::filesystem::path> out;
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(root, ec)) {
+        out.push_back(root);
+        return out;
+    }
+    for (auto it = std::filesystem::recursive_directory_iterator(root, std::filesystem::directory_options::skip_permission_denied, ec);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        if (!it->is_regular_file(ec)) continue;
+        std::wstring ext = it->path().extension().wstring();
+        for (auto& c : ext) c = (wchar_t)towupper(c);
+        if (ext == L".RSC" || ext == L".QRC") out.push_back(it->path());
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static bool SameTokens(const arena2::TokenizedText& a, const arena2::TokenizedText& b) {
+    std::string pa, pb, ra, rb;
+    arena2::RenderPlain(a, pa);
+    arena2::RenderPlain(b, pb);
+    arena2::RenderRich(a, ra);
+    arena2::RenderRich(b, rb);
+    if (pa != pb || ra != rb || a.plainLength != b.plainLength || a.hasEndOfPage != b.hasEndOfPage || a.hasFontScript != b.hasFontScript) return false;
+    if (a.tokens.size() != b.tokens.size() || a.vars.size() != b.vars.size()) return false;
+    for (size_t i = 0; i < a.tokens.size(); ++i) {
+        const auto& x = a.tokens[i];
+        const auto& y = b.tokens[i];
+        if (x.type != y.type || x.arg0 != y.arg0 || x.arg1 != y.arg1 || a.TextOf(x) != b.TextOf(y) || x.byteOffset != y.byteOffset) return false;
+    }
+    for (size_t i = 0; i < a.vars.size(); ++i) {
+        const auto& x = a.vars[i];
+        const auto& y = b.vars[i];
+        if (x.style != y.style || a.TokenOf(x) != b.TokenOf(y) || x.name != y.name || x.hash != y.hash ||
+            x.plainOffset != y.plainOffset || x.byteOffset != y.byteOffset) return false;
+    }
+    return true;
+}
+
+// Tokenizes every subrecord with the scalar scanner and with each vector scanner and compares the results.
+static int CmdVerifyTextScan(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        Print(L"usage: --verify-text-scan <TEXT.RSC | .QRC | folder>");
+        return 2;
+    }
+    auto files = FindTextDbFiles(args[1]);
+    if (files.empty()) {
+        Print(L"No .RSC/.QRC files found under " + args[1]);
+        return 1;
+    }
+
+    const arena2::TextScanMode modes[] = { arena2::TextScanMode::Scalar, arena2::TextScanMode::Sse2, arena2::TextScanMode::Avx2 };
+    const arena2::TextScanMode original = arena2::ActiveTextScanMode();
+    arena2::SetTextScanMode(arena2::TextScanMode::Avx2);
+    const arena2::TextScanMode widest = arena2::ActiveTextScanMode();   // SSE2 again on CPUs without AVX2
+    double seconds[3]{};
+    size_t subrecords = 0, bytes = 0, mismatches = 0, loaded = 0;
+
+    using Clock = std::chrono::steady_clock;
+    for (const auto& path : files) {
+        arena2::TextRsc rsc;
+        std::wstring err;
+        if (!arena2::TextRsc::LoadFromFile(path, rsc, &err)) continue;
+        loaded++;
+        for (auto& rec : rsc.records) {
+            rec.EnsureParsed(rsc.fileBytes);
+            for (const auto& sr : rec.subrecords) {
+                arena2::TokenizedText results[3];
+                for (size_t m = 0; m < 3; ++m) {
+                    arena2::SetTextScanMode(modes[m]);
+                    auto t0 = Clock::now();
+                    results[m] = arena2::TokenizeTextSubrecord(sr.raw, rsc.strings.get());
+                    seconds[m] += std::chrono::duration<double>(Clock::now() - t0).count();
+                }
+                subrecords++;
+                bytes += sr.raw.size();
+                if (!SameTokens(results[0], results[1]) || !SameTokens(results[0], results[2])) {
+                    if (++mismatches <= 20) {
+                        wchar_t buf[512]{};
+                        swprintf_s(buf, L"  MISMATCH %s record %u", path.filename().wstring().c_str(), (unsigned)rec.recordId);
+                        Print(buf);
+                    }
+                }
+            }
+        }
+    }
+    arena2::SetTextScanMode(original);
+
+    const double mb = double(bytes) / (1024.0 * 1024.0);
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"%zu files, %zu subrecords, %.2f MB: scalar %.1f MB/s, SSE2 %.1f MB/s, %s %.1f MB/s, mismatches %zu",
+               loaded, subrecords, mb,
+               seconds[0] > 0 ? mb / seconds[0] : 0.0, seconds[1] > 0 ? mb / seconds[1] : 0.0,
+               arena2::TextScanModeName(widest), seconds[2] > 0 ? mb / seconds[2] : 0.0, mismatches);
+    Print(buf);
+    return mismatches ? 1 : 0;
+}
+
+// Writes every database back unchanged (records must come back byte for byte), then with every subrecord
+// overridden by its own rich rendering (each must render the same after re-encoding and reloading).
+static int CmdVerifyTextWriter(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        Print(L"usage: --verify-text-writer <TEXT.RSC | .QRC | folder>");
+        return 2;
+    }
+    auto files = FindTextDbFiles(args[1]);
+    if (files.empty()) {
+        Print(L"No .RSC/.QRC files found under " + args[1]);
+        return 1;
+    }
+
+    auto recordBytes = [](const arena2::TextRsc& db, const arena2::TextRecord& r) {
+        return std::span<const uint8_t>(db.fileBytes).subspan(r.start, r.end - r.start);
+    };
+
+    using Clock = std::chrono::steady_clock;
+    double copySeconds = 0;
+    size_t loaded = 0, identicalFiles = 0, subrecords = 0, mismatches = 0;
+    uint64_t copyBytes = 0;
+    for (const auto& path : files) {
+        arena2::TextRsc rsc;
+        std::wstring err;
+        if (!arena2::TextRsc::LoadFromFile(path, rsc, &err)) continue;
+        loaded++;
+
+        auto report = [&](const wchar_t* what, unsigned recordId) {
+            if (++mismatches <= 20) {
+                wchar_t buf[512]{};
+                swprintf_s(buf, L"  MISMATCH %s record %u: %s", path.filename().wstring().c_str(), recordId, what);
+                Print(buf);
+            }
+        };
+
+        std::vector<uint8_t> bytes;
+        auto t0 = Clock::now();
+        if (!arena2::WriteTextDatabase(rsc, bytes, nullptr, &err)) {
+            report(err.c_str(), 0);
+            continue;
+        }
+        copySeconds += std::chrono::duration<double>(Clock::now() - t0).count();
+        copyBytes += bytes.size();
+        if (bytes == rsc.fileBytes) identicalFiles++;
+
+        arena2::TextRsc copy;
+        if (!arena2::TextRsc::LoadFromBytes(bytes, path, copy, &err) || copy.records.size() != rsc.records.size()) {
+            report(L"unchanged write did not reload", 0);
+            continue;
+        }
+        for (size_t i = 0; i < rsc.records.size(); ++i) {
+            const auto& a = rsc.records[i];
+            const auto& b = copy.records[i];
+            const auto ab = recordBytes(rsc, a), bb = recordBytes(copy, b);
+            if (a.recordId != b.recordId || !std::equal(ab.begin(), ab.end(), bb.begin(), bb.end())) report(L"unchanged record differs", a.recordId);
+        }
+
+        std::vector<std::vector<std::string>> rich(rsc.records.size());
+        for (size_t i = 0; i < rsc.records.size(); ++i) {
+            auto& rec = rsc.records[i];
+            rec.EnsureParsed(rsc.fileBytes);
+            for (auto& sr : rec.subrecords) {
+                std::string text;
+                arena2::RenderRich(sr.EnsureTokens(), text);
+                sr.SetOverride(text);
+                rich[i].push_back(std::move(text));
+            }
+        }
+        arena2::TextRsc encoded;
+        if (!arena2::WriteTextDatabase(rsc, bytes, nullptr, &err) || !arena2::TextRsc::LoadFromBytes(std::move(bytes), path, encoded, &err) ||
+            encoded.records.size() != rsc.records.size()) {
+            report(L"re-encoded write did not reload", 0);
+            continue;
+        }
+        for (size_t i = 0; i < encoded.records.size(); ++i) {
+            auto& rec = encoded.records[i];
+            rec.EnsureParsed(encoded.fileBytes);
+            // A record with no subrecords is written as nothing and reloads the same way.
+            if (rec.subrecords.size() != rich[i].size() && !(rich[i].empty() && rec.subrecords.size() <= 1)) {
+                report(L"subrecord count differs", rec.recordId);
+                continue;
+            }
+            for (size_t s = 0; s < rich[i].size(); ++s) {
+                std::string text;
+                arena2::RenderRich(rec.subrecords[s].EnsureTokens(), text);
+                subrecords++;
+                if (text != rich[i][s]) report(L"re-encoded subrecord renders differently", rec.recordId);
+            }
+        }
+    }
+
+    const double mb = double(copyBytes) / (1024.0 * 1024.0);
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"%zu files (%zu byte-identical), %.2f MB written unchanged at %.0f MB/s, %zu subrecords re-encoded, mismatches %zu",
+               loaded, identicalFiles, mb, copySeconds > 0 ? mb / copySeconds : 0.0, subrecords, mismatches);
+    Print(buf);
+    return mismatches ? 1 : 0;
+}
+
+// Loads a quest folder cold (QBNs and every QRC), snapshots it, reloads through the snapshot and snapshots that
+// again: the two snapshots serialize every field, so they must come out byte for byte the same.
+static int CmdVerifyQuestSnapshot(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        Print(L"usage: --verify-quest-snapshot <ARENA2 | Battlespire folder>");
+        return 2;
+    }
+    const std::filesystem::path folder = args[1];
+    std::error_code ec;
+    const auto cacheDir = std::filesystem::temp_directory_path(ec) / L"DaggerfallCS-quest-snapshot";
+    std::filesystem::remove_all(cacheDir, ec);
+
+    auto load = [&](arena2::QuestCatalog& c, const std::filesystem::path& snapshotDir, std::wstring& err) {
+        return c.LoadFromArena2Root(folder, nullptr, &err, snapshotDir) || c.LoadFromBattlespireRoot(folder, nullptr, &err, snapshotDir);
+    };
+
+    using Clock = std::chrono::steady_clock;
+    std::wstring err;
+    arena2::QuestCatalog cold;
+    auto t0 = Clock::now();
+    if (!load(cold, {}, err)) {
+        Print(L"Failed to load quests: " + err);
+        return 1;
+    }
+    for (size_t i = 0; i < cold.quests.size(); ++i) cold.EnsureQrcLoaded(i, nullptr);
+    const double coldMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+    if (!arena2::SaveQuestSnapshot(cacheDir / L"a", cold, &err)) {
+        Print(L"Failed to write snapshot: " + err);
+        return 1;
+    }
+
+    arena2::QuestCatalog warm;
+    t0 = Clock::now();
+    if (!load(warm, cacheDir / L"a", err) || !warm.fromSnapshot) {
+        Print(L"Snapshot was not used on reload.");
+        return 1;
+    }
+    const double warmMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+    if (warm.quests.size() != cold.quests.size()) {
+        wchar_t buf[128]{};
+        swprintf_s(buf, L"  MISMATCH quest count: %zu cold, %zu from the snapshot", cold.quests.size(), warm.quests.size());
+        Print(buf);
+        std::filesystem::remove_all(cacheDir, ec);
+        return 1;
+    }
+
+    size_t qrcs = 0, mismatches = 0;
+    for (size_t i = 0; i < cold.quests.size(); ++i) {
+        const auto& a = cold.quests[i];
+        const auto& b = warm.quests[i];
+        qrcs += b.qrcLoaded;
+        if (a.qbnLoaded != b.qbnLoaded || a.qrcLoaded != b.qrcLoaded || a.displayName != b.displayName ||
+            a.displayNameSourceRecord != b.displayNameSourceRecord || a.guildName != b.guildName) {
+            if (++mismatches <= 20) Print(L"  MISMATCH " + winutil::WidenUtf8(a.baseName));
+        }
+    }
+
+    std::vector<uint8_t> snapA, snapB;
+    if (!arena2::SaveQuestSnapshot(cacheDir / L"b", warm, &err)) {
+        Print(L"Failed to write second snapshot: " + err);
+        return 1;
+    }
+    for (auto [dir, bytes] : { std::pair{ L"a", &snapA }, std::pair{ L"b", &snapB } }) {
+        std::ifstream f(arena2::QuestSnapshotPath(cacheDir / dir, cold.arena2Root), std::ios::binary);
+        bytes->assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+    if (snapA.empty() || snapA != snapB) {
+        Print(L"  MISMATCH snapshot written from the reloaded catalog differs");
+        mismatches++;
+    }
+    std::filesystem::remove_all(cacheDir, ec);
+
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"%zu quests (%zu QRCs), %.2f MB snapshot: cold load %.1f ms, snapshot load %.1f ms, mismatches %zu",
+               warm.quests.size(), qrcs, double(snapA.size()) / (1024.0 * 1024.0), coldMs, warmMs, mismatches);
+    Print(buf);
+    return mismatches ? 1 : 0;
+}
+
+static bool ParseRefKind(const std::wstring& s, arena2::QbnRefKind& kind) {
+    static const std::pair<const wchar_t*, arena2::QbnRefKind> kKinds[] = {
+        { L"state", arena2::QbnRefKind::State }, { L"item", arena2::QbnRefKind::Item },
+        { L"npc", arena2::QbnRefKind::Npc }, { L"location", arena2::QbnRefKind::Location },
+        { L"timer", arena2::QbnRefKind::Timer }, { L"mob", arena2::QbnRefKind::Mob },
+        { L"message", arena2::QbnRefKind::Message },
+    };
+    for (const auto& [name, k] : kKinds) {
+        if (_wcsicmp(s.c_str(), name) == 0) {
+            kind = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Brute-force reference scan of one QBN's op-codes, written out separately from QbnXref::Build so the two
+// can be checked against each other. Hits come out in (op-code, slot) order, as the index sorts them.
+static void ScanOpCodeRefs(const arena2::QuestQbn& qbn, arena2::QbnRefKind kind, uint16_t id, uint32_t quest,
+                           std::vector<arena2::QuestCatalogRef>& out) {
+    using arena2::QbnRefKind;
+    const uint32_t key = arena2::QbnXref::Key(kind, id);
+    for (size_t o = 0; o < qbn.opcodes.size() && o <= 0xFFFF; ++o) {
+        const auto& op = qbn.opcodes[o];
+        const uint16_t oi = static_cast<uint16_t>(o);
+        if (kind == QbnRefKind::Message) {
+            const auto& msg = op.sub[1];
+            if (op.opCode == 0x0017 && msg.sectionId == 0 && msg.localPtr == 0x12345678 && msg.value < 0xFFFFu && msg.value == id) out.push_back({ key, quest, oi, 1 });
+            if (op.messageId == id && id != 0x0000u && id != 0xFFFFu) out.push_back({ key, quest, oi, arena2::QbnXref::kMessageSlot });
+            continue;
+        }
+        for (uint8_t i = 0; i < 5; ++i) {
+            const auto& sr = op.sub[i];
+            bool match = false;
+            switch (kind) {
+            case QbnRefKind::Item: match = sr.sectionId == 0 && sr.localPtr != 0x12345678; break;
+            case QbnRefKind::Npc: match = sr.sectionId == 3; break;
+            case QbnRefKind::Location: match = sr.sectionId == 4; break;
+            case QbnRefKind::Timer: match = sr.sectionId == 6; break;
+            case QbnRefKind::Mob: match = sr.sectionId == 7; break;
+            case QbnRefKind::State: match = sr.sectionId == 9; break;
+            default: break;
+            }
+            if (match && sr.LinkedIndex() == id) out.push_back({ key, quest, oi, i });
+        }
+    }
+}
+
+// Reverse lookup through the catalog index, checked against a brute-force scan of every quest's op-codes.
+static int CmdQuestXref(const std::vector<std::wstring>& args) {
+    arena2::QbnRefKind kind{};
+    if (args.size() < 4 || !ParseRefKind(args[2], kind)) {
+        Print(L"usage: --quest-xref <ARENA2 | Battlespire folder> <state|item|npc|location|timer|mob|message> <id>");
+        return 2;
+    }
+    const unsigned long id = wcstoul(args[3].c_str(), nullptr, 0);
+    if (id > 0xFFFF) {
+        Print(L"id must fit in 16 bits");
+        return 2;
+    }
+    const std::filesystem::path folder = args[1];
+
+    std::wstring err;
+    arena2::QuestCatalog catalog;
+    if (!catalog.LoadFromArena2Root(folder, nullptr, &err) && !catalog.LoadFromBattlespireRoot(folder, nullptr, &err)) {
+        Print(L"Failed to load quests: " + err);
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    const auto hits = catalog.xref.Find(kind, (uint16_t)id);
+    const auto questHits = catalog.xref.QuestsReferencing(kind, (uint16_t)id);
+    const double indexUs = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+
+    t0 = Clock::now();
+    std::vector<arena2::QuestCatalogRef> scanned;
+    for (size_t qi = 0; qi < catalog.quests.size(); ++qi) {
+        if (catalog.quests[qi].qbnLoaded) ScanOpCodeRefs(catalog.quests[qi].qbn, kind, (uint16_t)id, (uint32_t)qi, scanned);
+    }
+    const double scanUs = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+    const bool match = std::equal(hits.begin(), hits.end(), scanned.begin(), scanned.end(),
+                                  [](const arena2::QuestCatalogRef& a, const arena2::QuestCatalogRef& b) {
+                                      return a.quest == b.quest && a.opcode == b.opcode && a.slot == b.slot;
+                                  });
+
+    for (uint32_t qi : questHits) {
+        const auto& q = catalog.quests[qi];
+        std::wstring line = L"  " + winutil::WidenUtf8(q.baseName) + L":";
+        for (const auto& r : hits) {
+            if (r.quest != qi) continue;
+            wchar_t buf[64]{};
+            if (r.slot == arena2::QbnXref::kMessageSlot) swprintf_s(buf, L" op#%u(%04X msg)", r.opcode, q.qbn.opcodes[r.opcode].opCode);
+            else swprintf_s(buf, L" op#%u(%04X s%u)", r.opcode, q.qbn.opcodes[r.opcode].opCode, r.slot);
+            line += buf;
+        }
+        Print(line);
+    }
+
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"%zu references in %zu of %zu quests (%zu indexed): catalog lookup %.1f us, op-code scan %.1f us%s",
+               hits.size(), questHits.size(), catalog.quests.size(), catalog.xref.refs.size(), indexUs, scanUs,
+               match ? L"" : L", MISMATCH against op-code scan");
+    Print(buf);
+    if (!match) {
+        swprintf_s(buf, L"  op-code scan found %zu references", scanned.size());
+        Print(buf);
+    }
+    return match ? 0 : 1;
+}
+
+static int CmdSimulateQuests(const std::vector<std::wstring>& args) {
+    if (args.size() < 2) {
+        Print(L"usage: --simulate-quests <ARENA2 | Battlespire folder> [runs per quest] [seed]");
+        return 2;
+    }
+    const std::filesystem::path folder = args[1];
+    arena2::QuestSimOptions options;
+    if (args.size() > 2) options.runs = (uint32_t)std::max(_wtoi(args[2].c_str()), 1);
+    if (args.size() > 3) options.seed = _wcstoui64(args[3].c_str(), nullptr, 0);
+
+    std::wstring err;
+    arena2::QuestCatalog catalog;
+    if (!catalog.LoadFromArena2Root(folder, nullptr, &err) && !catalog.LoadFromBattlespireRoot(folder, nullptr, &err)) {
+        Print(L"Failed to load quests: " + err);
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto t0 = Clock::now();
+    const auto stats = arena2::SimulateQuests(catalog, options);
+    const double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    uint64_t runs = 0, completed = 0;
+    size_t questsWithDead = 0;
+    for (size_t i = 0; i < stats.size(); ++i) {
+        const auto& s = stats[i];
+        if (!s.runs) continue;
+        runs += s.runs;
+        completed += s.completed;
+
+        const size_t dead = s.DeadStates();
+        questsWithDead += dead != 0;
+        wchar_t buf[256]{};
+        swprintf_s(buf, L"  %-10s completed %5.1f%%  avg %7.1f ticks  states %zu/%zu reached",
+                   winutil::WidenUtf8(catalog.quests[i].baseName).c_str(), 100.0 * s.completed / s.runs, s.AverageTicks(),
+                   s.stateReached.size() - dead, s.stateReached.size());
+        std::wstring line = buf;
+        if (dead) {
+            line += L"  dead:";
+            size_t listed = 0;
+            for (size_t st = 0; st < s.stateReached.size() && listed < 12; ++st) {
+                if (s.stateReached[st]) continue;
+                line += L" " + std::to_wstring(st);
+                listed++;
+            }
+            if (dead > listed) line += L" ...";
+        }
+        Print(line);
+    }
+
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"%llu runs over %zu quests in %.2f s (%.0f runs/s): %.1f%% completed within %u ticks, %zu quests with dead states",
+               (unsigned long long)runs, stats.size(), seconds, seconds > 0 ? runs / seconds : 0.0,
+               runs ? 100.0 * completed / runs : 0.0, options.maxTicks, questsWithDead);
+    Print(buf);
+    return 0;
+}
+
+bool IsHeadlessCommand(std::wstring_view arg) {
+    return arg.size() > 2 && arg[0] == L'-' && arg[1] == L'-';
+}
+
+int RunHeadless(const std::vector<std::wstring>& args) {
+    if (args.empty()) return 2;
+    const std::wstring& cmd = args[0];
+    if (cmd == L"--bench-lzss") return CmdBenchLzss(args);
+    if (cmd == L"--extract-bsa") return CmdExtractBsa(args);
+    if (cmd == L"--repack-bsa") return CmdRepackBsa(args);
+    if (cmd == L"--verify-text-scan") return CmdVerifyTextScan(args);
+    if (cmd == L"--verify-text-writer") return CmdVerifyTextWriter(args);
+    if (cmd == L"--verify-quest-snapshot") return CmdVerifyQuestSnapshot(args);
+    if (cmd == L"--quest-xref") return CmdQuestXref(args);
+    if (cmd == L"--simulate-quests") return CmdSimulateQuests(args);
+
+    Print(L"Unknown command: " + cmd);
+    Print(L"Commands:");
+    Print(L"  --bench-lzss <folder> [repeat]   decode every compressed BSA entry, verify against the reference decoder and report throughput");
+    Print(L"  --extract-bsa <archive> [outDir] extract every entry (default outDir: <exe dir>\\<stem>_extracted)");
+    Print(L"  --repack-bsa <src> <overrideDir|-> <out> [--recompress]  rebuild an archive with replaced entries and verify it");
+    Print(L"  --verify-text-scan <file|folder> tokenize every TEXT.RSC/QRC subrecord with the scalar and SIMD scanners and compare");
+    Print(L"  --verify-text-writer <file|folder> write every TEXT.RSC/QRC back unchanged and fully re-encoded, and compare");
+    Print(L"  --verify-quest-snapshot <folder> load a quest folder cold and through a quest snapshot, and compare");
+    Print(L"  --quest-xref <folder> <state|item|npc|location|timer|mob|message> <id>  list the quests and op-codes referencing an id");
+    Print(L"  --simulate-quests <folder> [runs] [seed]  run seeded playthroughs of every quest; report completion and unreachable states");
+    return 2;
+}
+
+} // namespace cli
@@ -0,0 +1,13 @@
+#pragma once
+#include "../pch.h"
+
+namespace cli {
+
+// Command-line entry points that run without creating the main window, e.g.
+//   DaggerfallCS.exe --bench-lzss <folder> [repeat]
+//   DaggerfallCS.exe --extract-bsa <archive.bsa> [outDir]
+// An unknown --command prints the full list (see the help text at the end of RunHeadless).
+bool IsHeadlessCommand(std::wstring_view arg);
+int RunHeadless(const std::vector<std::wstring>& args);
+
+} // namespace cli
@@ -0,0 +1,30 @@
+#include "pch.h"
+#include "ExportPipeline.h"
+#include "../util/Parallel.h"
+
+namespace csv {
+
+void AppendRowsParallel(std::string& out, size_t count, const std::function<void(size_t index, std::string& shardOut)>& formatItem,
+                        size_t workers) {
+    if (count == 0) return;
+    if (workers == 0) workers = winutil::DefaultWorkerCount();
+
+    // Several shards per worker so a few heavy records (books) do not leave the rest of the pool idle.
+    const size_t shardCount = std::min(count, workers * 8);
+    std::vector<std::string> shards(shardCount);
+    winutil::ParallelFor(shardCount, workers, [&](size_t s, size_t) {
+        const size_t begin = count * s / shardCount;
+        const size_t end = count * (s + 1) / shardCount;
+        for (size_t i = begin; i < end; ++i) formatItem(i, shards[s]);
+    });
+
+    size_t total = out.size();
+    for (const auto& s : shards) total += s.size();
+    out.reserve(total);
+    for (auto& s : shards) {
+        out.append(s);
+        std::string().swap(s);
+    }
+}
+
+}
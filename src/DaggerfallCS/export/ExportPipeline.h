@@ -0,0 +1,14 @@
+#pragma once
+#include "../pch.h"
+#include <functional>
+
+namespace csv {
+
+// Appends the rows of items [0, count) to out on a worker pool. The items are cut into contiguous shards, each
+// shard is formatted into its own buffer by formatItem(index, shardOut), and the buffers are appended in index
+// order, so the result is byte-identical to calling formatItem for every index in turn.
+// formatItem runs concurrently for different indices.
+void AppendRowsParallel(std::string& out, size_t count, const std::function<void(size_t index, std::string& shardOut)>& formatItem,
+                        size_t workers = 0);
+
+}
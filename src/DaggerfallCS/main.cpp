@@ -1,7 +1,17 @@
 #include "pch.h"
 #include "ui/MainWindow.h"
+#include "cli/Headless.h"
 
 int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int nCmdShow) {
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv && argc > 1 && cli::IsHeadlessCommand(argv[1])) {
+        std::vector<std::wstring> args(argv + 1, argv + argc);
+        LocalFree(argv);
+        return cli::RunHeadless(args);
+    }
+    if (argv) LocalFree(argv);
+
     INITCOMMONCONTROLSEX icc{};
     icc.dwSize = sizeof(icc);
     icc.dwICC = ICC_TREEVIEW_CLASSES | ICC_LISTVIEW_CLASSES | ICC_BAR_CLASSES;
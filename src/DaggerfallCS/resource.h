@@ -13,16 +13,22 @@
 #define IDC_INDICES_STATIC_TYPE    1015
 #define IDC_INDICES_STATIC_IMPL    1016
 #define IDC_INDICES_STATIC_COMMENT    1017
+#define IDC_FIND_TEXT_QUERY    1020
+#define IDC_FIND_TEXT_RESULTS    1021
+#define IDC_FIND_TEXT_INFO    1022
 
 #define IDM_FILE_OPEN_ARENA2     40001
 #define IDM_FILE_OPEN_SPIRE      40004
 #define IDM_FILE_EXIT            40002
 #define IDM_FILE_INDICES         40003
 #define IDM_FILE_EXTRACT_BSA     40005
+#define IDM_FILE_FIND_TEXT       40006
 #define IDM_EXPORT_SUBRECORDS    40010
 #define IDM_EXPORT_TOKENS        40011
 #define IDM_EXPORT_VARIABLES     40012
 #define IDM_EXPORT_QUESTS        40013
 #define IDM_EXPORT_QUEST_STAGES  40014
 #define IDM_EXPORT_TES4_QD       40015
+#define IDM_EXPORT_TEXT_DB       40016
 #define IDM_HELP_ABOUT           40100
+#define IDM_HELP_DIAGNOSTICS     40101
@@ -0,0 +1,221 @@
+#include "pch.h"
+#include "FindTextWindow.h"
+#include "MainWindow.h"
+#include "../resource.h"
+#include "../util/WinUtil.h"
+#include <chrono>
+
+namespace ui {
+
+static const int COL_SOURCE  = 0;
+static const int COL_RECORD  = 1;
+static const int COL_SUB     = 2;
+static const int COL_OFFSET  = 3;
+static const int COL_CONTEXT = 4;
+
+static constexpr size_t kMaxHits = 2000;
+static constexpr size_t kContextChars = 40;
+
+const wchar_t* FindTextWindow::ClassName() { return L"DaggerfallCS_FindText"; }
+
+bool FindTextWindow::Create(HINSTANCE hInst, HWND owner, MainWindow* main) {
+    m_owner = owner;
+    m_main = main;
+
+    WNDCLASSEXW wc{};
+    wc.cbSize = sizeof(wc);
+    wc.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
+    wc.hCursor = LoadCursorW(nullptr, IDC_ARROW);
+    wc.hIcon = LoadIconW(nullptr, IDI_APPLICATION);
+    wc.hInstance = hInst;
+    wc.lpfnWndProc = FindTextWindow::WndProc;
+    wc.lpszClassName = ClassName();
+    wc.style = CS_HREDRAW | CS_VREDRAW;
+
+    RegisterClassExW(&wc);
+
+    m_hwnd = CreateWindowExW(
+        WS_EX_TOOLWINDOW,
+        ClassName(),
+        L"Find Text",
+        WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_THICKFRAME,
+        CW_USEDEFAULT, CW_USEDEFAULT, 900, 520,
+        owner, nullptr, hInst, this
+    );
+
+    return m_hwnd != nullptr;
+}
+
+void FindTextWindow::Show() {
+    if (!m_hwnd) return;
+    ShowWindow(m_hwnd, SW_SHOW);
+    SetForegroundWindow(m_hwnd);
+    SetFocus(m_query);
+}
+
+void FindTextWindow::Hide() {
+    if (!m_hwnd) return;
+    ShowWindow(m_hwnd, SW_HIDE);
+}
+
+bool FindTextWindow::OnCreate() {
+    m_query = CreateWindowExW(WS_EX_CLIENTEDGE, L"EDIT", L"",
+        WS_CHILD | WS_VISIBLE | WS_TABSTOP | ES_AUTOHSCROLL,
+        0, 0, 100, 24, m_hwnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(IDC_FIND_TEXT_QUERY)), GetModuleHandleW(nullptr), nullptr);
+
+    m_info = CreateWindowExW(0, L"STATIC", L"",
+        WS_CHILD | WS_VISIBLE,
+        0, 0, 100, 20, m_hwnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(IDC_FIND_TEXT_INFO)), GetModuleHandleW(nullptr), nullptr);
+
+    m_list = CreateWindowExW(WS_EX_CLIENTEDGE, WC_LISTVIEWW, L"",
+        WS_CHILD | WS_VISIBLE | WS_TABSTOP | LVS_REPORT | LVS_SINGLESEL | LVS_SHOWSELALWAYS,
+        0, 0, 100, 100, m_hwnd, reinterpret_cast<HMENU>(static_cast<INT_PTR>(IDC_FIND_TEXT_RESULTS)), GetModuleHandleW(nullptr), nullptr);
+    ListView_SetExtendedListViewStyle(m_list, LVS_EX_FULLROWSELECT | LVS_EX_DOUBLEBUFFER);
+
+    InitColumns();
+    RunQuery();
+    return true;
+}
+
+void FindTextWindow::OnDestroy() {
+    m_hwnd = nullptr;
+}
+
+void FindTextWindow::OnSize(int cx, int cy) {
+    const int pad = 10;
+    const int queryH = 24;
+    const int infoW = 260;
+
+    MoveWindow(m_query, pad, pad, cx - infoW - pad * 3, queryH, TRUE);
+    MoveWindow(m_info, cx - infoW - pad, pad + 3, infoW, queryH - 3, TRUE);
+
+    const int listY = pad + queryH + pad;
+    MoveWindow(m_list, pad, listY, cx - pad * 2, cy - listY - pad, TRUE);
+}
+
+void FindTextWindow::InitColumns() {
+    LVCOLUMNW col{};
+    col.mask = LVCF_TEXT | LVCF_WIDTH | LVCF_SUBITEM;
+
+    auto add = [&](int index, int cx, const wchar_t* title) {
+        col.cx = cx;
+        col.iSubItem = index;
+        col.pszText = const_cast<wchar_t*>(title);
+        ListView_InsertColumn(m_list, index, &col);
+    };
+    add(COL_SOURCE, 110, L"Source");
+    add(COL_RECORD, 70, L"Record");
+    add(COL_SUB, 40, L"Sub");
+    add(COL_OFFSET, 60, L"Offset");
+    add(COL_CONTEXT, 560, L"Context");
+}
+
+void FindTextWindow::Refresh() {
+    if (m_hwnd) RunQuery();
+}
+
+void FindTextWindow::RunQuery() {
+    if (!m_main) return;
+
+    ListView_DeleteAllItems(m_list);
+    m_hits.clear();
+
+    const arena2::TextSearchIndex* index = m_main->TextSearch();
+    if (!index) {
+        SetWindowTextW(m_info, L"Indexing text...");
+        return;
+    }
+
+    wchar_t qbuf[256]{};
+    GetWindowTextW(m_query, qbuf, 256);
+    const std::string query = winutil::NarrowUtf8(qbuf);
+    if (query.empty()) {
+        SetWindowTextW(m_info, L"");
+        return;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    m_hits = index->Find(query, kMaxHits);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    SendMessageW(m_list, WM_SETREDRAW, FALSE, 0);
+    for (int i = 0; i < (int)m_hits.size(); ++i) {
+        const auto& h = m_hits[i];
+
+        std::wstring source = m_main->SearchSourceName(h.source);
+        LVITEMW it{};
+        it.mask = LVIF_TEXT | LVIF_PARAM;
+        it.iItem = i;
+        it.pszText = const_cast<wchar_t*>(source.c_str());
+        it.lParam = (LPARAM)i;
+        ListView_InsertItem(m_list, &it);
+
+        wchar_t buf[32]{};
+        swprintf_s(buf, L"0x%04X", (unsigned)h.recordId);
+        ListView_SetItemText(m_list, i, COL_RECORD, buf);
+        swprintf_s(buf, L"%u", (unsigned)h.subrecord);
+        ListView_SetItemText(m_list, i, COL_SUB, buf);
+        swprintf_s(buf, L"%u", h.offset);
+        ListView_SetItemText(m_list, i, COL_OFFSET, buf);
+
+        const std::string_view text = index->TextOf(h);
+        const size_t from = h.offset > kContextChars ? h.offset - kContextChars : 0;
+        std::string ctx(text.substr(from, (h.offset - from) + query.size() + kContextChars));
+        for (auto& ch : ctx) if (ch == '\r' || ch == '\n' || ch == '\t' || ch == '\f') ch = ' ';
+        std::wstring ctxW = winutil::WidenUtf8(ctx);
+        ListView_SetItemText(m_list, i, COL_CONTEXT, const_cast<wchar_t*>(ctxW.c_str()));
+    }
+    SendMessageW(m_list, WM_SETREDRAW, TRUE, 0);
+
+    wchar_t info[128]{};
+    swprintf_s(info, L"%zu%s hits in %.2f ms", m_hits.size(), m_hits.size() >= kMaxHits ? L"+" : L"", ms);
+    SetWindowTextW(m_info, info);
+}
+
+void FindTextWindow::OnActivate(int item) {
+    if (!m_main || item < 0 || item >= (int)m_hits.size()) return;
+    m_main->RevealSearchHit(m_hits[item]);
+}
+
+LRESULT CALLBACK FindTextWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
+    FindTextWindow* self = nullptr;
+    if (msg == WM_NCCREATE) {
+        auto* cs = reinterpret_cast<CREATESTRUCTW*>(lParam);
+        self = reinterpret_cast<FindTextWindow*>(cs->lpCreateParams);
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)self);
+        self->m_hwnd = hwnd;
+    } else {
+        self = reinterpret_cast<FindTextWindow*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    }
+
+    if (!self) return DefWindowProcW(hwnd, msg, wParam, lParam);
+
+    switch (msg) {
+    case WM_CREATE:
+        return self->OnCreate() ? 0 : -1;
+    case WM_DESTROY:
+        self->OnDestroy();
+        return 0;
+    case WM_SIZE:
+        self->OnSize(LOWORD(lParam), HIWORD(lParam));
+        return 0;
+    case WM_CLOSE:
+        self->Hide();
+        return 0;
+    case WM_COMMAND:
+        if (LOWORD(wParam) == IDC_FIND_TEXT_QUERY && HIWORD(wParam) == EN_CHANGE) { self->RunQuery(); return 0; }
+        break;
+    case WM_NOTIFY:
+        if (((LPNMHDR)lParam)->hwndFrom == self->m_list && ((LPNMHDR)lParam)->code == NM_DBLCLK) {
+            self->OnActivate(((NMITEMACTIVATE*)lParam)->iItem);
+            return 0;
+        }
+        break;
+    default:
+        break;
+    }
+
+    return DefWindowProcW(hwnd, msg, wParam, lParam);
+}
+
+} // namespace ui
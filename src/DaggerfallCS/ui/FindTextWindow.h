@@ -0,0 +1,42 @@
+#pragma once
+#include "../pch.h"
+#include "../arena2/TextSearch.h"
+
+namespace ui {
+
+class MainWindow;
+
+class FindTextWindow {
+public:
+    bool Create(HINSTANCE hInst, HWND owner, MainWindow* main);
+    void Show();
+    void Hide();
+    bool IsOpen() const { return m_hwnd != nullptr; }
+
+    // Re-runs the current query (the index arrived or a subrecord was edited).
+    void Refresh();
+
+    static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
+
+private:
+    HWND m_hwnd{};
+    HWND m_owner{};
+    HWND m_query{};
+    HWND m_list{};
+    HWND m_info{};
+
+    MainWindow* m_main{};
+    std::vector<arena2::TextSearchHit> m_hits;
+
+    bool OnCreate();
+    void OnDestroy();
+    void OnSize(int cx, int cy);
+    void OnActivate(int item);
+
+    void InitColumns();
+    void RunQuery();
+
+    static const wchar_t* ClassName();
+};
+
+} // namespace ui
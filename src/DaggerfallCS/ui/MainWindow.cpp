@@ -2,11 +2,18 @@
 #include "MainWindow.h"
 #include "../resource.h"
 #include "../util/WinUtil.h"
+#include "../util/Hash64.h"
+#include "../util/NameHash.h"
+#include "../util/Parallel.h"
 #include "../export/CsvWriter.h"
+#include "../export/ExportPipeline.h"
 #include "../arena2/QuestOpcodeDisasm.h"
+#include "../arena2/QuestSnapshot.h"
+#include "../arena2/TextRscWriter.h"
 #include "../battlespire/BattlespireFormats.h"
 #include <cmath>
 #include <deque>
+#include <mutex>
 #include <unordered_set>
 
 namespace ui {
@@ -18,9 +25,37 @@ struct MainWindow::LoadResult {
     arena2::QuestCatalog quests;
     bool questsOk{ false };
     std::vector<battlespire::BsaArchive> bsaArchives;
+    size_t bsaFromSidecar{};
     bool bsaOk{ false };
 };
 
+// Entry metadata computed in the background for archives whose sidecar was missing or stale.
+struct MainWindow::BsaMetaResult {
+    std::vector<std::pair<uint32_t, std::vector<battlespire::BsaEntryMeta>>> byCacheId;
+};
+
+struct MainWindow::SearchIndexResult {
+    uint32_t generation{};
+    std::unique_ptr<arena2::TextSearchIndex> index;
+};
+
+struct MainWindow::QrcPreloadResult {
+    struct Quest {
+        size_t index{};
+        arena2::TextRsc qrc;
+        std::string displayName;
+        uint16_t displayNameSourceRecord{};
+        arena2::TextSearchIndex search;   // the QRC's text, merged into the main search index on arrival
+    };
+    uint32_t generation{};
+    std::vector<Quest> quests;
+    bool last{};   // the job's final batch
+};
+
+static std::filesystem::path CacheDir() {
+    return winutil::GetExeDirectory() / L"cache";
+}
+
 static const wchar_t* kWndClass = L"DaggerfallCS_MainWindow";
 static std::wstring HexU32(uint32_t v);
 static std::string TextureTagHex(const std::array<uint8_t, 6>& t) {
@@ -315,8 +350,22 @@ struct BsiPreviewTexture {
     std::vector<uint8_t> indices;
     std::array<COLORREF, 256> palette{};
     bool hasPalette{ false };
+    uint64_t contentHash{};   // Hash64 of the BSI bytes it was decoded from
 };
 
+// Work skipped because a payload with the same content hash had already been decoded.
+struct PreviewDedupeStats {
+    uint64_t textureHits{};
+    uint64_t textureBytes{};   // decoded pixel bytes not held twice
+    uint64_t meshHits{};
+    uint64_t meshBytes{};      // mesh file bytes not parsed twice
+};
+
+static PreviewDedupeStats& PreviewDedupe() {
+    static PreviewDedupeStats s;
+    return s;
+}
+
 static constexpr uint32_t kMaxBsiBytes = 16u * 1024u * 1024u;
 static constexpr int kMaxBsiDimension = 4096;
 static constexpr int kMaxBsiFrames = 64;
@@ -467,8 +516,22 @@ static std::unordered_map<std::string, std::string>& TextureResolveCache() {
     return s;
 }
 
-static std::unordered_map<std::string, BsiPreviewTexture>& BsiTextureCache() {
-    static std::unordered_map<std::string, BsiPreviewTexture> s;
+// Stem -> decoded texture (null when the stem did not resolve). Stems whose files have identical bytes share
+// one texture through BsiTextureByContent.
+static std::unordered_map<std::string, std::shared_ptr<const BsiPreviewTexture>>& BsiTextureCache() {
+    static std::unordered_map<std::string, std::shared_ptr<const BsiPreviewTexture>> s;
+    return s;
+}
+
+static std::unordered_map<uint64_t, std::shared_ptr<const BsiPreviewTexture>>& BsiTextureByContent() {
+    static std::unordered_map<uint64_t, std::shared_ptr<const BsiPreviewTexture>> s;
+    return s;
+}
+
+// Content hash -> parsed level mesh, kept across previews so model names and levels that reuse a file's bytes
+// parse it once.
+static std::unordered_map<uint64_t, std::shared_ptr<const battlespire::B3dMesh>>& MeshByContent() {
+    static std::unordered_map<uint64_t, std::shared_ptr<const battlespire::B3dMesh>> s;
     return s;
 }
 
@@ -483,29 +546,54 @@ static std::unordered_set<std::string>& TextureStreamQueuedSet() {
 }
 
 static constexpr size_t kMaxTextureCacheEntries = 4096;
+static constexpr size_t kMaxMeshCacheEntries = 2048;
 static const std::string kMissResolveStem = "__MISS__";
 
-static std::vector<const battlespire::BsaArchive*>& TextureSourceArchives() {
-    static std::vector<const battlespire::BsaArchive*> s;
+// Texture lookup goes through the loose bsi_extracted folder first, then every loaded archive except the
+// audio/text ones; level meshes through 3D.BSA, then the loose 3D_extracted folder.
+static battlespire::AssetVfs& TextureVfs() {
+    static battlespire::AssetVfs s;
+    return s;
+}
+
+static battlespire::AssetVfs& ModelVfs() {
+    static battlespire::AssetVfs s;
     return s;
 }
 
-static void RefreshTextureSourceArchives(const std::vector<battlespire::BsaArchive>& archives) {
-    auto& out = TextureSourceArchives();
-    out.clear();
+static void RefreshPreviewAssetVfs(const std::vector<battlespire::BsaArchive>& archives) {
     TextureResolveCache().clear();
     BsiTextureCache().clear();
+    BsiTextureByContent().clear();
+    MeshByContent().clear();
     TextureStreamQueue().clear();
     TextureStreamQueuedSet().clear();
+
+    // The indexes only depend on which archives are loaded; re-list the loose folders only when that changes.
+    static std::vector<uint32_t> mountedIds;
+    std::vector<uint32_t> ids;
+    ids.reserve(archives.size());
+    for (const auto& a : archives) ids.push_back(a.cacheId);
+    if (ids == mountedIds && TextureVfs().MountCount() > 0) return;
+    mountedIds = std::move(ids);
+
+    auto& textures = TextureVfs();
+    auto& models = ModelVfs();
+    textures.Clear();
+    models.Clear();
+    textures.MountDirectory(std::filesystem::path("batspire") / "bsi_extracted", 1);
+    models.MountDirectory(std::filesystem::path("batspire") / "3D_extracted", 0);
     for (const auto& a : archives) {
         std::wstring wn = a.sourcePath.filename().wstring();
         for (auto& c : wn) c = (wchar_t)towlower(c);
+        if (wn == L"3d.bsa") models.MountArchive(a, 1);
         if (wn == L"waves.bsa" || wn == L"txt.bsa") continue;
-        out.push_back(&a);
+        textures.MountArchive(a, 0);
     }
+    textures.BuildIndex();
+    models.BuildIndex();
 }
 
-
 static bool TryDecodeBsiFromAnyOffset(const std::vector<uint8_t>& bytes, BsiPreviewTexture& out) {
     if (bytes.empty() || bytes.size() > kMaxBsiBytes) return false;
     if (TryDecodeBsiPreviewTexture(bytes, out)) return true;
@@ -523,36 +611,33 @@ static bool TryDecodeBsiFromAnyOffset(const std::vector<uint8_t>& bytes, BsiPrev
     return false;
 }
 
-static BsiPreviewTexture LoadTextureByStemSync(const std::string& stem) {
-    BsiPreviewTexture tex{};
+static std::shared_ptr<const BsiPreviewTexture> LoadTextureByStemSync(const std::string& stem) {
     std::vector<uint8_t> bytes;
+    auto& byContent = BsiTextureByContent();
+    const auto& vfs = TextureVfs();
+    for (const auto* loc = vfs.FindByStem(stem, ".BSI"); loc; loc = vfs.Next(*loc)) {
+        if (loc->archive == nullptr && (loc->size == 0 || loc->size > kMaxBsiBytes)) continue;
+        std::wstring err;
+        if (!vfs.Read(*loc, bytes, &err)) continue;
+        if (bytes.size() > kMaxBsiBytes) continue;
 
-    std::ifstream tf("batspire/bsi_extracted/" + stem + ".BSI", std::ios::binary);
-    if (tf) {
-        tf.seekg(0, std::ios::end);
-        size_t n = (size_t)tf.tellg();
-        tf.seekg(0, std::ios::beg);
-        if (n > 0 && n <= kMaxBsiBytes) {
-            bytes.resize(n);
-            tf.read(reinterpret_cast<char*>(bytes.data()), (std::streamsize)n);
-            if (tf.good() || tf.eof()) TryDecodeBsiFromAnyOffset(bytes, tex);
+        // Archive metadata already carries the hash of the decoded entry; loose files are hashed here.
+        const auto* meta = loc->entry ? loc->archive->MetaFor(*loc->entry) : nullptr;
+        const uint64_t hash = (meta && meta->decodedSize == bytes.size()) ? meta->contentHash : winutil::Hash64(bytes.data(), bytes.size());
+        auto it = byContent.find(hash);
+        if (it != byContent.end()) {
+            PreviewDedupe().textureHits++;
+            PreviewDedupe().textureBytes += it->second->indices.size();
+            return it->second;
         }
-    }
 
-    if (tex.indices.empty()) {
-        const std::string name = stem + ".BSI";
-        for (const auto* arc : TextureSourceArchives()) {
-            if (!arc) continue;
-            const auto* e = arc->FindEntryCaseInsensitive(name);
-            if (!e) continue;
-            std::wstring err;
-            std::vector<uint8_t> arcBytes;
-            if (!arc->ReadEntryData(*e, arcBytes, &err)) continue;
-            if (arcBytes.size() > kMaxBsiBytes) continue;
-            if (TryDecodeBsiFromAnyOffset(arcBytes, tex)) break;
-        }
+        auto tex = std::make_shared<BsiPreviewTexture>();
+        if (!TryDecodeBsiFromAnyOffset(bytes, *tex)) continue;
+        tex->contentHash = hash;
+        byContent.emplace(hash, tex);
+        return tex;
     }
-    return tex;
+    return nullptr;
 }
 
 static uint64_t& TextureCacheEpoch() {
@@ -569,8 +654,8 @@ static void PumpTextureStreaming(size_t budget) {
         queue.pop_front();
         queued.erase(stem);
         if (cache.find(stem) != cache.end()) continue;
-        BsiPreviewTexture tex = LoadTextureByStemSync(stem);
-        if (cache.size() >= kMaxTextureCacheEntries) { cache.clear(); TextureCacheEpoch()++; }
+        auto tex = LoadTextureByStemSync(stem);
+        if (cache.size() >= kMaxTextureCacheEntries) { cache.clear(); BsiTextureByContent().clear(); TextureCacheEpoch()++; }
         cache.insert({ stem, std::move(tex) });
     }
 }
@@ -583,8 +668,7 @@ static const BsiPreviewTexture* TryGetTextureByStem(const std::string& stemIn, b
     auto& cache = BsiTextureCache();
     auto it = cache.find(stem);
     if (it != cache.end()) {
-        if (it->second.indices.empty()) return nullptr;
-        return &it->second;
+        return it->second.get();
     }
 
     auto& queued = TextureStreamQueuedSet();
@@ -820,7 +904,7 @@ struct LevelPreviewGpu {
     IDirect3D9* d3d{};
     IDirect3DDevice9* dev{};
     D3DPRESENT_PARAMETERS pp{};
-    std::unordered_map<const BsiPreviewTexture*, IDirect3DTexture9*> textures;
+    std::unordered_map<uint64_t, IDirect3DTexture9*> textures;   // keyed by BsiPreviewTexture::contentHash
 
     ~LevelPreviewGpu() { Shutdown(); }
 
@@ -889,7 +973,7 @@ struct LevelPreviewGpu {
 
     IDirect3DTexture9* GetTexture(const BsiPreviewTexture* tex) {
         if (!dev || !tex || tex->indices.empty() || tex->width <= 0 || tex->height <= 0) return nullptr;
-        auto it = textures.find(tex);
+        auto it = textures.find(tex->contentHash);
         if (it != textures.end()) return it->second;
 
         IDirect3DTexture9* outTex = nullptr;
@@ -919,7 +1003,7 @@ struct LevelPreviewGpu {
             for (auto& kv : textures) if (kv.second) kv.second->Release();
             textures.clear();
         }
-        textures.insert({ tex, outTex });
+        textures.insert({ tex->contentHash, outTex });
         return outTex;
     }
 };
@@ -1911,7 +1995,7 @@ static std::wstring TopicGroupForLabel(const std::wstring& label) {
     return L"Other";
 }
 
-static std::string CheapPreview(const std::vector<uint8_t>& raw) {
+static std::string CheapPreview(std::span<const uint8_t> raw) {
     std::string out;
     out.reserve(220);
     for (size_t i = 0; i < raw.size() && out.size() < 220; ++i) {
@@ -1948,18 +2032,21 @@ static bool LooksLikeBookRecord(arena2::TextRecord& rec, const std::vector<uint8
     int score = 0;
     if (IsBookLikeLabel(std::wstring(label))) score += 2;
 
+    // Streams the tokens: the tree build runs this over every record, most of which are never displayed.
     size_t plainBytes = 0;
-    for (auto& sr : rec.subrecords) {
-        auto& tok = sr.EnsureTokens();
-        plainBytes += tok.plain.size();
-        if (tok.hasEndOfPage) score += 3;
-        if (tok.hasFontScript) score += 2;
-        for (const auto& t : tok.tokens) {
-            if (t.type == arena2::TokenType::BookImage) {
-                score += 2;
-                break;
-            }
+    for (const auto& sr : rec.subrecords) {
+        bool endOfPage = false, fontScript = false, bookImage = false;
+        arena2::TokenCursor cursor(sr.raw);
+        arena2::Token t;
+        while (cursor.Next(t)) {
+            if (t.type == arena2::TokenType::EndOfPage) endOfPage = true;
+            else if (t.type == arena2::TokenType::Font && t.arg0 == 0x02) fontScript = true;
+            else if (t.type == arena2::TokenType::BookImage) bookImage = true;
         }
+        plainBytes += cursor.PlainLength();
+        if (endOfPage) score += 3;
+        if (fontScript) score += 2;
+        if (bookImage) score += 2;
     }
 
     if (rec.subrecords.size() >= 2) score += 1;
@@ -2551,8 +2638,9 @@ static std::wstring DeriveBookTitle(arena2::TextRecord& rec, const std::vector<u
 
     rec.EnsureParsed(fileBytes);
     if (!rec.subrecords.empty()) {
-        auto& tok = rec.subrecords[0].EnsureTokens();
-        std::wstring plain = winutil::WidenUtf8(tok.plain);
+        std::string utf8;
+        arena2::RenderPlain(rec.subrecords[0].EnsureTokens(), utf8);
+        std::wstring plain = winutil::WidenUtf8(utf8);
 
         size_t pos = 0;
         while (pos < plain.size()) {
@@ -2627,6 +2715,7 @@ static HMENU BuildMenuBar() {
     AppendMenuW(hFile, MF_STRING, IDM_FILE_OPEN_SPIRE, L"Open spire Folder...");
     AppendMenuW(hFile, MF_STRING, IDM_FILE_EXTRACT_BSA, L"Extract BSA...");
     AppendMenuW(hFile, MF_STRING, IDM_FILE_INDICES, L"Indices...");
+    AppendMenuW(hFile, MF_STRING, IDM_FILE_FIND_TEXT, L"Find Text...");
     AppendMenuW(hFile, MF_SEPARATOR, 0, nullptr);
     AppendMenuW(hFile, MF_STRING, IDM_FILE_EXIT, L"Exit");
 
@@ -2638,7 +2727,10 @@ static HMENU BuildMenuBar() {
     AppendMenuW(hExport, MF_STRING, IDM_EXPORT_QUEST_STAGES, L"Export QUESTS_Stages.csv...");
     AppendMenuW(hExport, MF_SEPARATOR, 0, nullptr);
     AppendMenuW(hExport, MF_STRING, IDM_EXPORT_TES4_QD, L"Export TES4_QuestDialogue.txt...");
+    AppendMenuW(hExport, MF_SEPARATOR, 0, nullptr);
+    AppendMenuW(hExport, MF_STRING, IDM_EXPORT_TEXT_DB, L"Write TEXT.RSC with edits...");
 
+    AppendMenuW(hHelp, MF_STRING, IDM_HELP_DIAGNOSTICS, L"Diagnostics...");
     AppendMenuW(hHelp, MF_STRING, IDM_HELP_ABOUT, L"About");
 
     AppendMenuW(hMenubar, MF_POPUP, (UINT_PTR)hFile, L"File");
@@ -2701,9 +2793,11 @@ bool MainWindow::OnCreate() {
 
     // Disable exports until load
     HMENU hMenu = GetMenu(m_hwnd);
+    EnableMenuItem(hMenu, IDM_FILE_FIND_TEXT, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_SUBRECORDS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_TOKENS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_VARIABLES, MF_BYCOMMAND | MF_GRAYED);
+    EnableMenuItem(hMenu, IDM_EXPORT_TEXT_DB, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_QUESTS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_QUEST_STAGES, MF_BYCOMMAND | MF_GRAYED);
     DrawMenuBar(m_hwnd);
@@ -2773,6 +2867,10 @@ void MainWindow::OnCommand(WORD id) {
         m_indicesWnd.Refresh();
         m_indicesWnd.Show();
         break;
+    case IDM_FILE_FIND_TEXT:
+        if (!m_findWnd.IsOpen()) m_findWnd.Create(GetModuleHandleW(nullptr), m_hwnd, this);
+        m_findWnd.Show();
+        break;
     case IDM_FILE_EXIT: DestroyWindow(m_hwnd); break;
     case IDM_EXPORT_SUBRECORDS: CmdExportSubrecords(); break;
     case IDM_EXPORT_TOKENS: CmdExportTokens(); break;
@@ -2780,7 +2878,9 @@ void MainWindow::OnCommand(WORD id) {
     case IDM_EXPORT_QUESTS: CmdExportQuests(); break;
     case IDM_EXPORT_QUEST_STAGES: CmdExportQuestStages(); break;
     case IDM_EXPORT_TES4_QD: CmdExportTes4QuestDialogue(); break;
+    case IDM_EXPORT_TEXT_DB: CmdExportTextDatabase(); break;
     case IDM_BSA_DIALOGUE_SPEAK: break;
+    case IDM_HELP_DIAGNOSTICS: CmdShowDiagnostics(); break;
     case IDM_HELP_ABOUT:
         MessageBoxW(m_hwnd, L"Daggerfall-CS MVP\n\nLoads TEXT.RSC and Battlespire BSA resources and exports CSV.", L"About", MB_OK | MB_ICONINFORMATION);
         break;
@@ -2796,7 +2896,7 @@ void MainWindow::SetStatus(const std::wstring& s) {
 void MainWindow::SendLevelToPreview(const battlespire::Bs6Scene* scene, const std::wstring& label) {
     if (!m_levelPreview || !IsWindow(m_levelPreview)) return;
 
-    RefreshTextureSourceArchives(m_bsaArchives);
+    RefreshPreviewAssetVfs(m_bsaArchives);
 
     auto payload = std::make_unique<LevelPreviewScene>();
     payload->label = label;
@@ -2813,15 +2913,11 @@ void MainWindow::SendLevelToPreview(const battlespire::Bs6Scene* scene, const st
         payload->flasCount = scene->flasCount;
         payload->rawdCount = scene->rawdCount;
 
-        auto* modelsArchive = [&]() -> const battlespire::BsaArchive* {
-            for (const auto& a : m_bsaArchives) {
-                if (_wcsicmp(a.sourcePath.filename().wstring().c_str(), L"3D.BSA") == 0) return &a;
-            }
-            return nullptr;
-        }();
-
-        if (modelsArchive) {
-            std::unordered_map<std::string, battlespire::B3dMesh> meshCache;
+        const auto& modelVfs = ModelVfs();
+        if (modelVfs.IndexedCount() > 0) {
+            // Model names whose files have identical bytes share one parsed mesh.
+            std::unordered_map<std::string, std::shared_ptr<const battlespire::B3dMesh>> meshCache;
+            auto& meshByContent = MeshByContent();
             std::unordered_set<std::string> failedMeshKeys;
 
             float ambientNorm = std::clamp(float(payload->ambient) / 60000.0f, 0.0f, 1.0f);
@@ -2838,18 +2934,18 @@ void MainWindow::SendLevelToPreview(const battlespire::Bs6Scene* scene, const st
 
             auto colorFromTextureTag = [&](const std::array<uint8_t, 6>& t, const std::string& stemHint) -> COLORREF {
                 if (const auto* tex = TryGetTextureForFace(t, stemHint)) {
-                    uint32_t h = 2166136261u;
-                    for (uint8_t bt : t) h = (h ^ bt) * 16777619u;
+                    uint32_t h = winutil::kFnv1aBasis;
+                    for (uint8_t bt : t) h = winutil::Fnv1aStep(h, bt);
                     float u = float((h >> 8) % std::max(1, tex->width));
                     float v = float((h >> 16) % std::max(1, tex->height));
                     return applyLightScale(SampleTextureColor(*tex, u, v, false));
                 }
 
                 bool allZero = true;
-                uint32_t h = 2166136261u;
+                uint32_t h = winutil::kFnv1aBasis;
                 for (uint8_t bt : t) {
                     if (bt != 0) allZero = false;
-                    h = (h ^ bt) * 16777619u;
+                    h = winutil::Fnv1aStep(h, bt);
                 }
                 if (allZero) return applyLightScale(RGB(100, 100, 100));
 
@@ -2949,20 +3045,18 @@ void MainWindow::SendLevelToPreview(const battlespire::Bs6Scene* scene, const st
                 size_t modelDot = modelStem.find('.');
                 if (modelDot != std::string::npos) modelStem = modelStem.substr(0, modelDot);
 
-                auto resolveEntry = [&](const std::string& key) -> const battlespire::BsaEntry* {
-                    const auto* e = modelsArchive->FindEntryCaseInsensitive(key);
-                    if (e) return e;
+                auto resolveEntry = [&](std::string_view key) -> const battlespire::AssetLocation* {
+                    const auto* loc = modelVfs.Find(key);
+                    if (loc) return loc;
                     size_t slash = key.find_last_of("/\\");
-                    if (slash != std::string::npos) {
-                        std::string bn = key.substr(slash + 1);
-                        e = modelsArchive->FindEntryCaseInsensitive(bn);
-                        if (e) return e;
+                    if (slash != std::string_view::npos) {
+                        loc = modelVfs.Find(key.substr(slash + 1));
+                        if (loc) return loc;
                     }
                     size_t dot = key.find('.');
-                    if (dot != std::string::npos) {
-                        std::string stem = key.substr(0, dot);
-                        e = modelsArchive->FindEntryCaseInsensitive(stem + ".3D");
-                        if (e) return e;
+                    if (dot != std::string_view::npos) {
+                        loc = modelVfs.FindByStem(key.substr(0, dot), ".3D");
+                        if (loc) return loc;
                     }
                     return nullptr;
                 };
@@ -2982,32 +3076,25 @@ void MainWindow::SendLevelToPreview(const battlespire::Bs6Scene* scene, const st
                         continue;
                     }
 
-                    const auto* entry = resolveEntry(modelKey);
-                    if (!entry || entry->packedSize > kMaxMeshBytes) {
+                    const auto* location = resolveEntry(modelKey);
+                    if (!location || location->size > kMaxMeshBytes) {
                         failedMeshKeys.insert(modelKey);
                         missingNames.insert(modelKey);
                         invalidMeshInstances++;
                         continue;
                     }
 
+                    // A shadowed loose copy (3D_extracted) stands in when the archive entry cannot be read.
                     std::vector<uint8_t> bytes;
                     std::wstring err;
-                    const bool readOk = modelsArchive->ReadEntryData(*entry, bytes, &err);
-                    if ((!readOk || bytes.empty() || bytes.size() > kMaxMeshBytes) && entry) {
-                        std::filesystem::path extractedModel = std::filesystem::path("batspire") / "3D_extracted" / winutil::WidenUtf8(entry->name);
-                        if (std::filesystem::exists(extractedModel)) {
-                            std::ifstream f(extractedModel, std::ios::binary);
-                            if (f) {
-                                f.seekg(0, std::ios::end);
-                                const size_t n = size_t(f.tellg());
-                                f.seekg(0, std::ios::beg);
-                                if (n > 0 && n <= kMaxMeshBytes) {
-                                    bytes.resize(n);
-                                    f.read(reinterpret_cast<char*>(bytes.data()), (std::streamsize)n);
-                                    if (!(f.good() || f.eof())) bytes.clear();
-                                }
-                            }
+                    const battlespire::AssetLocation* readFrom = nullptr;
+                    for (const auto* loc = location; loc; loc = modelVfs.Next(*loc)) {
+                        if (loc->size > kMaxMeshBytes) continue;
+                        if (modelVfs.Read(*loc, bytes, &err) && !bytes.empty() && bytes.size() <= kMaxMeshBytes) {
+                            readFrom = loc;
+                            break;
                         }
+                        bytes.clear();
                     }
                     if (bytes.empty() || bytes.size() > kMaxMeshBytes) {
                         failedMeshKeys.insert(modelKey);
@@ -3016,55 +3103,69 @@ void MainWindow::SendLevelToPreview(const battlespire::Bs6Scene* scene, const st
                         continue;
                     }
 
-                    battlespire::B3dFileSummary summary;
-                    auto summaryInRange = [&](const std::vector<uint8_t>& src) -> bool {
-                        if (!battlespire::B3dFileSummary::TryParse(src, summary, &err)) return false;
-                        return summary.pointCount <= kMaxMeshPoints && summary.planeCount <= kMaxMeshPlanes;
-                    };
+                    // As for textures: archive metadata already carries the hash, loose files are hashed here.
+                    const auto* meta = readFrom->entry ? readFrom->archive->MetaFor(*readFrom->entry) : nullptr;
+                    const uint64_t contentHash = (meta && meta->decodedSize == bytes.size()) ? meta->contentHash : winutil::Hash64(bytes.data(), bytes.size());
+                    if (auto shared = meshByContent.find(contentHash); shared != meshByContent.end()) {
+                        PreviewDedupe().meshHits++;
+                        PreviewDedupe().meshBytes += bytes.size();
+                        mit = meshCache.insert({ modelKey, shared->second }).first;
+                    } else {
+                        // Forced-LZSS recovery only applies to archive entries.
+                        const battlespire::BsaEntry* entry = location->entry;
+                        const auto payloadView = entry ? location->archive->PayloadView(*entry) : std::span<const uint8_t>{};
+
+                        battlespire::B3dFileSummary summary;
+                        auto summaryInRange = [&](const std::vector<uint8_t>& src) -> bool {
+                            if (!battlespire::B3dFileSummary::TryParse(src, summary, &err)) return false;
+                            return summary.pointCount <= kMaxMeshPoints && summary.planeCount <= kMaxMeshPlanes;
+                        };
 
-                    if (!summaryInRange(bytes)) {
-                        // Recovery path: try forced LZSS decode for entries whose compression flag semantics are unknown.
-                        if (entry->compressionFlag != 0 && entry->offset <= modelsArchive->bytes.size() && entry->packedSize <= modelsArchive->bytes.size() - entry->offset) {
-                            const uint8_t* payloadPtr = modelsArchive->bytes.data() + entry->offset;
-                            std::vector<uint8_t> recovered;
-                            std::wstring recoverErr;
-                            if (battlespire::BsaArchive::DecompressLzss(payloadPtr, entry->packedSize, recovered, &recoverErr) && !recovered.empty() && recovered.size() <= kMaxMeshBytes) {
-                                if (summaryInRange(recovered)) bytes.swap(recovered);
+                        if (!summaryInRange(bytes)) {
+                            // Recovery path: try forced LZSS decode for entries whose compression flag semantics are unknown.
+                            if (entry && entry->compressionFlag != 0 && !payloadView.empty()) {
+                                std::vector<uint8_t> recovered;
+                                std::wstring recoverErr;
+                                if (battlespire::BsaArchive::DecompressLzss(payloadView.data(), payloadView.size(), recovered, &recoverErr) && !recovered.empty() && recovered.size() <= kMaxMeshBytes) {
+                                    if (summaryInRange(recovered)) bytes.swap(recovered);
+                                }
                             }
                         }
-                    }
 
-                    if (!summaryInRange(bytes)) {
-                        failedMeshKeys.insert(modelKey);
-                        missingNames.insert(modelKey);
-                        invalidMeshInstances++;
-                        continue;
-                    }
+                        if (!summaryInRange(bytes)) {
+                            failedMeshKeys.insert(modelKey);
+                            missingNames.insert(modelKey);
+                            invalidMeshInstances++;
+                            continue;
+                        }
 
-                    battlespire::B3dMesh mesh;
-                    if (!battlespire::B3dMesh::TryParse(bytes, mesh, &err)) {
-                        if (entry->compressionFlag != 0 && entry->offset <= modelsArchive->bytes.size() && entry->packedSize <= modelsArchive->bytes.size() - entry->offset) {
-                            const uint8_t* payloadPtr = modelsArchive->bytes.data() + entry->offset;
-                            std::vector<uint8_t> recovered;
-                            std::wstring recoverErr;
-                            if (battlespire::BsaArchive::DecompressLzss(payloadPtr, entry->packedSize, recovered, &recoverErr) && !recovered.empty() && recovered.size() <= kMaxMeshBytes) {
-                                if (battlespire::B3dMesh::TryParse(recovered, mesh, &err)) {
-                                    bytes.swap(recovered);
+                        battlespire::B3dMesh mesh;
+                        if (!battlespire::B3dMesh::TryParse(bytes, mesh, &err)) {
+                            if (entry && entry->compressionFlag != 0 && !payloadView.empty()) {
+                                std::vector<uint8_t> recovered;
+                                std::wstring recoverErr;
+                                if (battlespire::BsaArchive::DecompressLzss(payloadView.data(), payloadView.size(), recovered, &recoverErr) && !recovered.empty() && recovered.size() <= kMaxMeshBytes) {
+                                    if (battlespire::B3dMesh::TryParse(recovered, mesh, &err)) {
+                                        bytes.swap(recovered);
+                                    }
                                 }
                             }
                         }
+                        if (mesh.points.empty() || mesh.faces.empty()) {
+                            failedMeshKeys.insert(modelKey);
+                            missingNames.insert(modelKey);
+                            invalidMeshInstances++;
+                            continue;
+                        }
+                        auto parsed = std::make_shared<const battlespire::B3dMesh>(std::move(mesh));
+                        if (meshByContent.size() >= kMaxMeshCacheEntries) meshByContent.clear();
+                        meshByContent.emplace(contentHash, parsed);
+                        mit = meshCache.insert({ modelKey, std::move(parsed) }).first;
                     }
-                    if (mesh.points.empty() || mesh.faces.empty()) {
-                        failedMeshKeys.insert(modelKey);
-                        missingNames.insert(modelKey);
-                        invalidMeshInstances++;
-                        continue;
-                    }
-                    mit = meshCache.insert({ modelKey, std::move(mesh) }).first;
                 }
 
                 payload->resolvedInstances++;
-                const auto& mesh = mit->second;
+                const auto& mesh = *mit->second;
                 std::string modelKeyStem = NormalizeTextureStem(modelKey);
                 const std::string& textureStemHint = (!modelKeyStem.empty() && b3dResearch.knownFiles.find(modelKeyStem) != b3dResearch.knownFiles.end())
                     ? modelKeyStem
@@ -3140,6 +3241,7 @@ void MainWindow::StartTreeBuild() {
     m_pendingQuestIdx.clear();
     m_pendingQuestParents.clear();
     m_questInsertPos = 0;
+    m_questTreeItems.assign(m_quests.quests.size(), nullptr);
     m_bookRecordIds.clear();
     m_bookRecordTitles.clear();
 
@@ -3219,8 +3321,12 @@ void MainWindow::StartTreeBuild() {
             auto insertEntryNode = [&](HTREEITEM parent, size_t ei) {
                 const auto& e = a.entries[ei];
                 std::wstring label = winutil::WidenUtf8(e.name);
-                wchar_t suffix[96]{};
-                swprintf_s(suffix, L"  [off=0x%X, size=%u%s]", (unsigned)e.offset, (unsigned)e.packedSize, e.compressionFlag ? L", cmp" : L"");
+                wchar_t suffix[128]{};
+                if (const auto* meta = a.MetaFor(e); meta && e.compressionFlag) {
+                    swprintf_s(suffix, L"  [off=0x%X, size=%u, cmp -> %u]", (unsigned)e.offset, (unsigned)e.packedSize, (unsigned)meta->decodedSize);
+                } else {
+                    swprintf_s(suffix, L"  [off=0x%X, size=%u%s]", (unsigned)e.offset, (unsigned)e.packedSize, e.compressionFlag ? L", cmp" : L"");
+                }
                 label += suffix;
 
                 TVINSERTSTRUCTW eins{};
@@ -3601,6 +3707,10 @@ wchar_t sb[256]{};
     SetTimer(m_hwnd, TIMER_POP_TREE, 1, nullptr);
 }
 
+static std::wstring QuestTreeLabel(const arena2::QuestEntry& q) {
+    return winutil::WidenUtf8(q.baseName) + L" - " + winutil::WidenUtf8(!q.displayName.empty() ? q.displayName : q.guildName);
+}
+
 void MainWindow::TreeBuildTick() {
     const size_t totalText = m_pendingTreeIds.size();
     const size_t totalQuest = m_pendingQuestIdx.size();
@@ -3647,8 +3757,7 @@ void MainWindow::TreeBuildTick() {
         for (size_t i = m_questInsertPos; i < endQ; ++i) {
             size_t qidx = m_pendingQuestIdx[i];
             HTREEITEM parent = (i < m_pendingQuestParents.size()) ? m_pendingQuestParents[i] : m_treeRootQuests;
-            const auto& q = m_quests.quests[qidx];
-            std::wstring label = winutil::WidenUtf8(q.baseName) + L" - " + winutil::WidenUtf8(!q.displayName.empty() ? q.displayName : q.guildName);
+            std::wstring label = QuestTreeLabel(m_quests.quests[qidx]);
 
             TVINSERTSTRUCTW ins{};
             ins.hParent = parent;
@@ -3656,7 +3765,8 @@ void MainWindow::TreeBuildTick() {
             ins.item.mask = TVIF_TEXT | TVIF_PARAM;
             ins.item.pszText = const_cast<wchar_t*>(label.c_str());
             ins.item.lParam = (LPARAM)AddPayload(TreePayload::Kind::Quest, 0, qidx);
-            (void)SendMessageW(m_tree, TVM_INSERTITEMW, 0, (LPARAM)&ins);
+            HTREEITEM h = (HTREEITEM)SendMessageW(m_tree, TVM_INSERTITEMW, 0, (LPARAM)&ins);
+            if (qidx < m_questTreeItems.size()) m_questTreeItems[qidx] = h;
         }
 
         m_questInsertPos = endQ;
@@ -3681,11 +3791,11 @@ void MainWindow::PopulateSubrecordList(arena2::TextRecord& rec) {
     ListView_DeleteAllItems(m_list);
 
     for (int i = 0; i < (int)rec.subrecords.size(); ++i) {
-        const auto& sr = rec.subrecords[i];
+        auto& sr = rec.subrecords[i];
 
         std::wstring idx = std::to_wstring(i);
         std::string prev;
-        if (sr.hasUserOverride) prev = sr.userOverride;
+        if (sr.hasUserOverride) prev = sr.OverridePlain();
         else prev = CheapPreview(sr.raw);
         if (prev.size() > 220) prev.resize(220);
         for (auto& ch : prev) if (ch == '\r' || ch == '\n' || ch == '\t') ch = ' ';
@@ -3718,8 +3828,7 @@ void MainWindow::ShowSubrecordPreview(arena2::TextRecord& rec, int index) {
 
     NoteDiscoveredVars(tok);
 
-    const std::string& base = sr.hasUserOverride ? sr.userOverride : tok.rich;
-    std::string rich = ApplyOverrides(base);
+    std::string rich = ApplyOverrides(sr.EffectiveRich());
     std::wstring text = winutil::WidenUtf8(rich);
     SetWindowTextW(m_preview, text.c_str());
 
@@ -3743,6 +3852,33 @@ static std::wstring TrimOneLineW(std::wstring s, size_t maxChars) {
     return s;
 }
 
+// Full rich text of the subrecord behind a Preview cell (the cell itself is a truncated one-line summary).
+std::wstring MainWindow::ListPreviewRichText(int item) {
+    if (item < 0) return {};
+
+    if (m_viewMode == ViewMode::TextSubrecords) {
+        auto* pld = GetSelectedPayload();
+        if (!pld || pld->kind != TreePayload::Kind::TextRecord) return {};
+        auto* rec = m_text.FindMutable(pld->textRecordId);
+        if (!rec) return {};
+        rec->EnsureParsed(m_text.fileBytes);
+        if (item >= (int)rec->subrecords.size()) return {};
+        return winutil::WidenUtf8(std::string(rec->subrecords[item].EffectiveRich()));
+    }
+
+    if (m_viewMode == ViewMode::QuestText) {
+        if (!m_questsLoaded || m_activeQuest == (size_t)-1 || m_activeQuest >= m_quests.quests.size()) return {};
+        auto& q = m_quests.quests[m_activeQuest];
+        if (!q.qrcLoaded) return {};
+        if (item >= (int)q.qrc.records.size()) return {};
+        auto& rec = q.qrc.records[item];
+        rec.EnsureParsed(q.qrc.fileBytes);
+        if (rec.subrecords.empty()) return {};
+        return winutil::WidenUtf8(std::string(rec.subrecords[0].EffectiveRich()));
+    }
+    return {};
+}
+
 void MainWindow::BeginListPreviewEdit(int item, int subItem) {
     if (!m_list) return;
 
@@ -3761,27 +3897,37 @@ void MainWindow::BeginListPreviewEdit(int item, int subItem) {
     if (!ListView_GetSubItemRect(m_list, item, subItem, LVIR_LABEL, &rc)) return;
     if (rc.right <= rc.left || rc.bottom <= rc.top) return;
 
+    // Multi-line text with its markup; give it a few rows below the cell.
+    RECT client{};
+    GetClientRect(m_list, &client);
+    rc.bottom = std::min<LONG>(client.bottom, rc.top + (rc.bottom - rc.top) * 6);
+
     rc.left += 1;
     rc.top += 1;
     rc.right -= 1;
     rc.bottom -= 1;
 
-    wchar_t buf[4096]{};
-    ListView_GetItemText(m_list, item, subItem, buf, 4096);
-    std::wstring initial = buf;
+    m_inplaceOriginal = ListPreviewRichText(item);
+    std::wstring initial;
+    initial.reserve(m_inplaceOriginal.size());
+    for (wchar_t ch : m_inplaceOriginal) {
+        if (ch == L'\n') initial += L'\r';
+        initial += ch;
+    }
 
     m_inplaceItem = item;
     m_inplaceSubItem = subItem;
 
     m_inplaceEdit = CreateWindowExW(
         0, L"EDIT", initial.c_str(),
-        WS_CHILD | WS_VISIBLE | WS_BORDER | ES_AUTOHSCROLL,
+        WS_CHILD | WS_VISIBLE | WS_BORDER | WS_VSCROLL | ES_MULTILINE | ES_AUTOVSCROLL,
         rc.left, rc.top, rc.right - rc.left, rc.bottom - rc.top,
         m_list, nullptr, GetModuleHandleW(nullptr), nullptr
     );
     if (!m_inplaceEdit) {
         m_inplaceItem = -1;
         m_inplaceSubItem = -1;
+        m_inplaceOriginal.clear();
         return;
     }
 
@@ -3831,11 +3977,21 @@ void MainWindow::EndListPreviewEdit(bool commit) {
     m_inplaceEnding = false;
 
     if (commit) CommitListPreviewEdit(item, sub, newText);
+    else m_inplaceOriginal.clear();
 }
 
 void MainWindow::CommitListPreviewEdit(int item, int subItem, const std::wstring& newText) {
     (void)subItem;
-    std::wstring cleaned = TrimOneLineW(newText, 4096);
+    // The override is the full rich text (markup and line breaks included), as the TEXT.RSC writer encodes it.
+    std::wstring rich;
+    rich.reserve(newText.size());
+    for (wchar_t ch : newText) {
+        if (ch != L'\r') rich += ch;
+    }
+    const std::wstring original = std::move(m_inplaceOriginal);
+    m_inplaceOriginal.clear();
+    if (rich == original) return;
+    const std::string richUtf8 = winutil::NarrowUtf8(rich);
 
     // Apply to model depending on view mode.
     if (m_viewMode == ViewMode::TextSubrecords) {
@@ -3848,10 +4004,11 @@ void MainWindow::CommitListPreviewEdit(int item, int subItem, const std::wstring
         const int idx = item;
         if (idx < 0 || idx >= (int)rec->subrecords.size()) return;
 
-        rec->subrecords[idx].SetOverride(winutil::NarrowUtf8(cleaned));
+        rec->subrecords[idx].SetOverride(richUtf8);
+        UpdateSearchText(arena2::TextSearchIndex::kTextRsc, rec->recordId, static_cast<uint16_t>(idx), rec->subrecords[idx].OverridePlain());
 
         // Update list cell
-        std::wstring cell = TrimOneLineW(cleaned, 220);
+        std::wstring cell = TrimOneLineW(winutil::WidenUtf8(rec->subrecords[idx].OverridePlain()), 220);
         ListView_SetItemText(m_list, idx, 1, const_cast<LPWSTR>(cell.c_str()));
 
         ShowSubrecordPreview(*rec, idx);
@@ -3875,13 +4032,14 @@ void MainWindow::CommitListPreviewEdit(int item, int subItem, const std::wstring
 
         if (rec.subrecords.empty()) {
             arena2::TextSubrecord sr{};
-            sr.SetOverride(winutil::NarrowUtf8(cleaned));
+            sr.SetOverride(richUtf8);
             rec.subrecords.push_back(std::move(sr));
         } else {
-            rec.subrecords[0].SetOverride(winutil::NarrowUtf8(cleaned));
+            rec.subrecords[0].SetOverride(richUtf8);
         }
+        UpdateSearchText(static_cast<uint32_t>(m_activeQuest + 1), rec.recordId, 0, rec.subrecords[0].OverridePlain());
 
-        std::wstring cell = TrimOneLineW(cleaned, 96);
+        std::wstring cell = TrimOneLineW(winutil::WidenUtf8(rec.subrecords[0].OverridePlain()), 96);
         ListView_SetItemText(m_list, row, 2, const_cast<LPWSTR>(cell.c_str()));
 
         ShowQuestTextPreview(m_activeQuest, row);
@@ -3895,7 +4053,7 @@ LRESULT CALLBACK MainWindow::InplaceEditProc(HWND hwnd, UINT msg, WPARAM wParam,
 
     switch (msg) {
     case WM_KEYDOWN:
-        if (wParam == VK_RETURN) {
+        if (wParam == VK_RETURN && !(GetKeyState(VK_SHIFT) & 0x8000)) {   // Shift+Enter starts a new line
             if (self) self->EndListPreviewEdit(true);
             return 0;
         }
@@ -3916,6 +4074,56 @@ LRESULT CALLBACK MainWindow::InplaceEditProc(HWND hwnd, UINT msg, WPARAM wParam,
 
 
 
+static std::wstring FormatBsaCacheStatus() {
+    const auto st = battlespire::BsaEntryCache::Instance().Stats();
+    wchar_t buf[256]{};
+    swprintf_s(buf, L"Decoded cache: %llu hits, %llu misses, %llu evictions, %zu entries, %.1f / %.1f MB",
+               (unsigned long long)st.hits, (unsigned long long)st.misses, (unsigned long long)st.evictions, st.entries,
+               st.bytes / (1024.0 * 1024.0), st.byteBudget / (1024.0 * 1024.0));
+    return buf;
+}
+
+void MainWindow::CmdShowDiagnostics() {
+    // Identical payloads across the loaded archives, from the per-entry content hashes.
+    size_t hashed = 0, total = 0, duplicates = 0;
+    uint64_t duplicateBytes = 0;
+    std::unordered_set<uint64_t> seen;
+    for (const auto& a : m_bsaArchives) {
+        total += a.entries.size();
+        if (a.entryMeta.size() != a.entries.size()) continue;
+        for (const auto& m : a.entryMeta) {
+            hashed++;
+            if (!seen.insert(m.contentHash).second) {
+                duplicates++;
+                duplicateBytes += m.decodedSize;
+            }
+        }
+    }
+
+    const auto st = battlespire::BsaEntryCache::Instance().Stats();
+    const auto& dd = PreviewDedupe();
+    const auto ts = m_text.strings ? m_text.strings->Stats() : arena2::TextArenaStats{};
+    wchar_t buf[1024]{};
+    swprintf_s(buf,
+               L"Archives: %zu loaded, %zu of %zu entries hashed\n"
+               L"Duplicate payloads: %zu entries, %.2f MB decoded\n\n"
+               L"Decoded cache: %zu entries, %.1f / %.1f MB\n"
+               L"  %llu hits, %llu misses, %llu evictions\n"
+               L"  %llu served from identical content, %.2f MB shared\n\n"
+               L"Preview textures: %llu reused by content, %.2f MB not decoded twice\n"
+               L"Preview meshes: %llu reused by content, %.2f MB not parsed twice\n\n"
+               L"Text strings: %.2f / %.2f MB in %zu blocks, %zu distinct variable names",
+               m_bsaArchives.size(), hashed, total,
+               duplicates, duplicateBytes / (1024.0 * 1024.0),
+               st.entries, st.bytes / (1024.0 * 1024.0), st.byteBudget / (1024.0 * 1024.0),
+               (unsigned long long)st.hits, (unsigned long long)st.misses, (unsigned long long)st.evictions,
+               (unsigned long long)st.contentHits, st.sharedBytes / (1024.0 * 1024.0),
+               (unsigned long long)dd.textureHits, dd.textureBytes / (1024.0 * 1024.0),
+               (unsigned long long)dd.meshHits, dd.meshBytes / (1024.0 * 1024.0),
+               ts.usedBytes / (1024.0 * 1024.0), ts.reservedBytes / (1024.0 * 1024.0), ts.blocks, ts.internedStrings);
+    MessageBoxW(m_hwnd, buf, L"Diagnostics", MB_OK | MB_ICONINFORMATION);
+}
+
 void MainWindow::OnTreeSelChanged() {
     auto* p = GetSelectedPayload();
     if (!p) return;
@@ -4027,13 +4235,18 @@ void MainWindow::OnTreeSelChanged() {
             SetWindowTextW(m_preview, (L"Failed to decode BSA entry: " + err).c_str());
             return;
         }
+        SetStatus(winutil::WidenUtf8(e.name) + L"  |  " + FormatBsaCacheStatus());
 
         std::wstring preview;
         bool renderedTable = false;
 
+        // Stored metadata already says what the entry is; sniff when it is unknown or does not match these bytes.
+        const auto* meta = ar.MetaFor(e);
+        if (meta && (meta->kind == battlespire::BsaContentKind::Unknown || meta->decodedSize != bytes.size()))
+            meta = nullptr;
         std::wstring entryNameLower = ToLowerWs(winutil::WidenUtf8(e.name));
-        bool looksLikeBs6 = EndsWithWs(entryNameLower, L".bs6");
-        bool looksLike3d = EndsWithWs(entryNameLower, L".3d");
+        bool looksLikeBs6 = meta ? meta->kind == battlespire::BsaContentKind::Bs6 : EndsWithWs(entryNameLower, L".bs6");
+        bool looksLike3d = meta ? meta->kind == battlespire::BsaContentKind::Model3d : EndsWithWs(entryNameLower, L".3d");
         if (looksLikeBs6) {
             battlespire::Bs6FileSummary bs6;
             std::wstring perr;
@@ -4062,7 +4275,8 @@ void MainWindow::OnTreeSelChanged() {
             }
         }
 
-        if (IsLikelyUtf8Printable(bytes)) {
+        const bool printable = meta ? meta->kind == battlespire::BsaContentKind::Text : IsLikelyUtf8Printable(bytes);
+        if (printable) {
             std::wstring nameLow = ToLowerWs(winutil::WidenUtf8(e.name));
             std::string text(bytes.begin(), bytes.end());
             if (!IsMagicTxtBsaEntryName(nameLow) && text.size() > 131072) text.resize(131072);
@@ -4256,6 +4470,15 @@ void MainWindow::OnTreeSelChanged() {
 
 
 void MainWindow::CmdExtractBsa() {
+    if (m_extracting.load()) {
+        if (MessageBoxW(m_hwnd, (L"Extraction of " + m_extractLabel + L" is still running.\n\nCancel it?").c_str(),
+                        L"Extract BSA", MB_YESNO | MB_ICONQUESTION) == IDYES) {
+            m_extractCancel.store(true);
+            SetStatus(L"Cancelling BSA extraction...");
+        }
+        return;
+    }
+
     auto picked = winutil::PickFile(m_hwnd,
         L"Select Battlespire BSA to extract",
         L"Battlespire Archives (*.bsa)|*.bsa|All Files (*.*)|*.*");
@@ -4279,36 +4502,56 @@ void MainWindow::CmdExtractBsa() {
         return;
     }
 
-    size_t okCount = 0;
-    size_t failCount = 0;
-    for (size_t i = 0; i < archive.entries.size(); ++i) {
-        const auto& e = archive.entries[i];
+    m_extracting.store(true);
+    m_extractCancel.store(false);
+    m_extractLabel = bsaPath.filename().wstring();
+    SetStatus(L"Extracting " + m_extractLabel + L"...");
+
+    std::thread([hwnd = m_hwnd, archive = std::move(archive), outDir, cancel = &m_extractCancel]() {
+        // Post only when the percentage moves so the UI queue is not flooded on archives with many small entries.
+        std::atomic<int> lastPct{ -1 };
+        auto progress = [&](size_t done, size_t total) {
+            int pct = total ? (int)(done * 100 / total) : 100;
+            int prev = lastPct.load();
+            while (pct > prev) {
+                if (lastPct.compare_exchange_weak(prev, pct)) {
+                    PostMessageW(hwnd, WM_APP_EXTRACT_PROGRESS, (WPARAM)done, (LPARAM)total);
+                    break;
+                }
+            }
+        };
 
-        std::vector<uint8_t> bytes;
-        std::wstring derr;
-        if (!archive.ReadEntryData(e, bytes, &derr)) {
-            failCount++;
-            continue;
-        }
+        auto* r = new battlespire::BsaExtractResult();
+        std::wstring xerr;
+        battlespire::ExtractBsaArchive(archive, outDir, battlespire::BsaExtractOptions{}, cancel, progress, *r, &xerr);
+        PostMessageW(hwnd, WM_APP_EXTRACT_DONE, (WPARAM)r, 0);
+    }).detach();
+}
 
-        std::wstring name = winutil::WidenUtf8(e.name);
-        if (name.empty()) name = L"entry_" + std::to_wstring(i);
-        for (auto& c : name) {
-            if (c == L'/' || c == L'\\' || c == L':' || c == L'*' || c == L'?' || c == L'"' || c == L'<' || c == L'>' || c == L'|') c = L'_';
-        }
+void MainWindow::OnExtractProgress(size_t done, size_t total) {
+    if (!m_extracting.load()) return;
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"Extracting %s: %zu / %zu entries (%zu%%)", m_extractLabel.c_str(), done, total, total ? done * 100 / total : 100);
+    SetStatus(buf);
+}
+
+void MainWindow::OnExtractDone(battlespire::BsaExtractResult* r) {
+    m_extracting.store(false);
 
-        std::filesystem::path outPath = outDir / name;
-        std::ofstream f(outPath, std::ios::binary);
-        if (!f) { failCount++; continue; }
-        if (!bytes.empty()) f.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
-        if (!f.good()) { failCount++; continue; }
-        okCount++;
+    if (r->cancelled) {
+        std::wstring msg = L"Extraction cancelled after " + std::to_wstring(r->okCount + r->failCount) + L" of " + std::to_wstring(r->total) + L" entries.";
+        MessageBoxW(m_hwnd, msg.c_str(), L"Extract BSA", MB_OK | MB_ICONINFORMATION);
+        SetStatus(L"BSA extraction cancelled");
+        delete r;
+        return;
     }
 
-    std::wstring msg = L"Extracted " + std::to_wstring(okCount) + L" entries to:\n" + outDir.wstring();
-    if (failCount) msg += L"\n\nFailed entries: " + std::to_wstring(failCount);
-    MessageBoxW(m_hwnd, msg.c_str(), L"Extract BSA", MB_OK | (failCount ? MB_ICONWARNING : MB_ICONINFORMATION));
-    SetStatus(L"BSA extraction complete: " + std::to_wstring(okCount) + L" files");
+    std::wstring msg = L"Extracted " + std::to_wstring(r->okCount) + L" entries to:\n" + r->outDir.wstring();
+    if (r->failCount) msg += L"\n\nFailed entries: " + std::to_wstring(r->failCount);
+    if (r->fallbackCount) msg += L"\nWritten from an earlier entry of the same name: " + std::to_wstring(r->fallbackCount);
+    MessageBoxW(m_hwnd, msg.c_str(), L"Extract BSA", MB_OK | (r->failCount ? MB_ICONWARNING : MB_ICONINFORMATION));
+    SetStatus(L"BSA extraction complete: " + std::to_wstring(r->okCount) + L" files");
+    delete r;
 }
 
 void MainWindow::CmdOpenSpire() {
@@ -4324,9 +4567,11 @@ void MainWindow::CmdOpenSpire() {
     HMENU hMenu = GetMenu(m_hwnd);
     EnableMenuItem(hMenu, IDM_FILE_OPEN_SPIRE, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_FILE_OPEN_ARENA2, MF_BYCOMMAND | MF_GRAYED);
+    EnableMenuItem(hMenu, IDM_FILE_FIND_TEXT, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_SUBRECORDS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_TOKENS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_VARIABLES, MF_BYCOMMAND | MF_GRAYED);
+    EnableMenuItem(hMenu, IDM_EXPORT_TEXT_DB, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_QUESTS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_QUEST_STAGES, MF_BYCOMMAND | MF_GRAYED);
     DrawMenuBar(m_hwnd);
@@ -4354,7 +4599,7 @@ void MainWindow::CmdOpenSpire() {
             r->text = std::move(loaded);
 
             std::wstring qerr;
-            if (r->quests.LoadFromBattlespireRoot(spirePath, &qhash, &qerr)) {
+            if (r->quests.LoadFromBattlespireRoot(spirePath, &qhash, &qerr, CacheDir())) {
                 r->questsOk = true;
             } else {
                 r->questsOk = false;
@@ -4375,7 +4620,9 @@ void MainWindow::CmdOpenSpire() {
 
                     battlespire::BsaArchive arc;
                     std::wstring berr;
-                    if (battlespire::BsaArchive::LoadFromFile(it.path(), arc, &berr)) {
+                    bool fromSidecar = false;
+                    if (battlespire::OpenBsaArchive(it.path(), CacheDir(), arc, &fromSidecar, &berr)) {
+                        if (fromSidecar) r->bsaFromSidecar++;
                         r->bsaArchives.push_back(std::move(arc));
                     }
                 }
@@ -4403,9 +4650,11 @@ void MainWindow::CmdOpenArena2() {
 
     HMENU hMenu = GetMenu(m_hwnd);
     EnableMenuItem(hMenu, IDM_FILE_OPEN_ARENA2, MF_BYCOMMAND | MF_GRAYED);
+    EnableMenuItem(hMenu, IDM_FILE_FIND_TEXT, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_SUBRECORDS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_TOKENS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_VARIABLES, MF_BYCOMMAND | MF_GRAYED);
+    EnableMenuItem(hMenu, IDM_EXPORT_TEXT_DB, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_QUESTS, MF_BYCOMMAND | MF_GRAYED);
     EnableMenuItem(hMenu, IDM_EXPORT_QUEST_STAGES, MF_BYCOMMAND | MF_GRAYED);
     DrawMenuBar(m_hwnd);
@@ -4433,7 +4682,7 @@ void MainWindow::CmdOpenArena2() {
             r->text = std::move(loaded);
 
             std::wstring qerr;
-            if (r->quests.LoadFromArena2Root(arenaPath, &qhash, &qerr)) {
+            if (r->quests.LoadFromArena2Root(arenaPath, &qhash, &qerr, CacheDir())) {
                 r->questsOk = true;
             } else {
                 r->questsOk = false;
@@ -4481,7 +4730,9 @@ void MainWindow::CmdExportSubrecords() {
     out.reserve(1024 * 1024);
     csv::AppendRow(out, { "RecordId", "Group", "Category", "SubrecordIndex", "SubrecordCount", "PlainText", "RichText", "TokenCount", "HasEndOfPage", "HasFontScript" });
 
-    for (auto& r : m_text.records) {
+    // Records are formatted on a worker pool; the rows come out in record order.
+    csv::AppendRowsParallel(out, m_text.records.size(), [&](size_t ri, std::string& rows) {
+        auto& r = m_text.records[ri];
         r.EnsureParsed(m_text.fileBytes);
 
         std::wstring wcat;
@@ -4494,13 +4745,21 @@ void MainWindow::CmdExportSubrecords() {
         std::string cat = winutil::NarrowUtf8(wcat);
         std::string grp = winutil::NarrowUtf8(TopicGroupForLabel(wcat));
 
+        std::string plainBuf, richBuf;
         for (size_t i = 0; i < r.subrecords.size(); ++i) {
             auto& sr = r.subrecords[i];
             auto& tok = sr.EnsureTokens();
-            const std::string& basePlain = sr.hasUserOverride ? sr.userOverride : tok.plain;
-            const std::string& baseRich  = sr.hasUserOverride ? sr.userOverride : tok.rich;
+            // Rendered into reused buffers rather than cached on the subrecord: the export touches every record once.
+            if (!sr.hasUserOverride) {
+                plainBuf.clear();
+                richBuf.clear();
+                arena2::RenderPlain(tok, plainBuf);
+                arena2::RenderRich(tok, richBuf);
+            }
+            const std::string_view basePlain = sr.hasUserOverride ? sr.OverridePlain() : std::string_view(plainBuf);
+            const std::string_view baseRich  = sr.hasUserOverride ? std::string_view(sr.userOverride) : std::string_view(richBuf);
 
-            csv::AppendRow(out, {
+            csv::AppendRow(rows, {
                 U16Hex(r.recordId),
                 grp,
                 cat,
@@ -4515,9 +4774,9 @@ void MainWindow::CmdExportSubrecords() {
         }
 
         if (r.subrecords.empty()) {
-            csv::AppendRow(out, { U16Hex(r.recordId), grp, cat, "0", "0", "", "", "0", "0", "0" });
+            csv::AppendRow(rows, { U16Hex(r.recordId), grp, cat, "0", "0", "", "", "0", "0", "0" });
         }
-    }
+    });
 
     std::wstring err;
     auto path = *folder / "TEXT_RSC_Subrecords.csv";
@@ -4541,7 +4800,8 @@ void MainWindow::CmdExportTokens() {
     out.reserve(1024 * 1024);
     csv::AppendRow(out, { "RecordId", "Group", "Category", "SubrecordIndex", "TokenIndex", "TokenType", "Arg0", "Arg1", "Text", "ByteOffset" });
 
-    for (auto& r : m_text.records) {
+    csv::AppendRowsParallel(out, m_text.records.size(), [&](size_t ri, std::string& rows) {
+        auto& r = m_text.records[ri];
         r.EnsureParsed(m_text.fileBytes);
 
         std::wstring wcat;
@@ -4555,13 +4815,10 @@ void MainWindow::CmdExportTokens() {
         std::string grp = winutil::NarrowUtf8(TopicGroupForLabel(wcat));
 
         for (size_t si = 0; si < r.subrecords.size(); ++si) {
-            auto& sr = r.subrecords[si];
-            auto& tt = sr.EnsureTokens();
-
-            for (size_t ti = 0; ti < tt.tokens.size(); ++ti) {
-                const auto& tok = tt.tokens[ti];
-
-                csv::AppendRow(out, {
+            arena2::TokenCursor cursor(r.subrecords[si].raw);
+            arena2::Token tok;
+            for (size_t ti = 0; cursor.Next(tok); ++ti) {
+                csv::AppendRow(rows, {
                     U16Hex(r.recordId),
                     grp,
                     cat,
@@ -4570,12 +4827,12 @@ void MainWindow::CmdExportTokens() {
                     TokenTypeToString(tok.type),
                     std::to_string(tok.arg0),
                     std::to_string(tok.arg1),
-                    tok.text,
+                    std::string(cursor.TextOf(tok)),
                     std::to_string(tok.byteOffset)
                 });
             }
         }
-    }
+    });
 
     std::wstring err;
     auto path = *folder / "TEXT_RSC_Tokens.csv";
@@ -4616,7 +4873,8 @@ void MainWindow::CmdExportVariables() {
         return std::string(b);
     };
 
-    for (auto& r : m_text.records) {
+    csv::AppendRowsParallel(out, m_text.records.size(), [&](size_t ri, std::string& rows) {
+        auto& r = m_text.records[ri];
         r.EnsureParsed(m_text.fileBytes);
 
         std::wstring wcat;
@@ -4630,38 +4888,40 @@ void MainWindow::CmdExportVariables() {
         std::string grp = winutil::NarrowUtf8(TopicGroupForLabel(wcat));
 
         for (size_t si = 0; si < r.subrecords.size(); ++si) {
-            auto& sr = r.subrecords[si];
-            auto& tt = sr.EnsureTokens();
-
-            for (const auto& vr : tt.vars) {
-                std::string style = (vr.style == arena2::VarStyle::Percent) ? "Percent" : "Underscore";
-
-                std::string cand;
-                if (m_varHashLoaded) {
-                    if (auto* names = m_varHash.NamesFor(vr.hash)) {
-                        for (size_t i = 0; i < names->size(); ++i) {
-                            if (i) cand.push_back('|');
-                            cand.append((*names)[i]);
+            arena2::TokenCursor cursor(r.subrecords[si].raw);
+            arena2::Token tok;
+            arena2::VarRef vr;
+            while (cursor.Next(tok)) {
+                while (cursor.NextVar(vr)) {
+                    std::string style = (vr.style == arena2::VarStyle::Percent) ? "Percent" : "Underscore";
+
+                    std::string cand;
+                    if (m_varHashLoaded) {
+                        if (auto* names = m_varHash.NamesFor(vr.hash)) {
+                            for (size_t i = 0; i < names->size(); ++i) {
+                                if (i) cand.push_back('|');
+                                cand.append((*names)[i]);
+                            }
                         }
                     }
-                }
 
-                csv::AppendRow(out, {
-                    U16Hex(r.recordId),
-                    grp,
-                    cat,
-                    std::to_string(si),
-                    style,
-                    vr.token,
-                    vr.name,
-                    hex32(vr.hash),
-                    cand,
-                    std::to_string(vr.plainOffset),
-                    std::to_string(vr.byteOffset)
-                });
+                    csv::AppendRow(rows, {
+                        U16Hex(r.recordId),
+                        grp,
+                        cat,
+                        std::to_string(si),
+                        style,
+                        std::string(cursor.TokenOf(vr)),
+                        std::string(vr.name),
+                        hex32(vr.hash),
+                        cand,
+                        std::to_string(vr.plainOffset),
+                        std::to_string(vr.byteOffset)
+                    });
+                }
             }
         }
-    }
+    });
 
     std::wstring err;
     auto path = *folder / "TEXT_RSC_Variables.csv";
@@ -4789,6 +5049,36 @@ void MainWindow::CmdExportQuestStages() {
 }
 
 
+void MainWindow::CmdExportTextDatabase() {
+    if (m_text.records.empty()) {
+        MessageBoxW(m_hwnd, L"No data loaded.", L"Export", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    auto folder = winutil::PickFolder(m_hwnd, L"Select output folder");
+    if (!folder) return;
+
+    const std::filesystem::path name = m_text.sourcePath.has_filename() ? m_text.sourcePath.filename() : std::filesystem::path(L"TEXT.RSC");
+    const auto path = *folder / name;
+    std::error_code ec;
+    if (std::filesystem::equivalent(path, m_text.sourcePath, ec)) {
+        MessageBoxW(m_hwnd, L"Choose a folder other than the one the database was loaded from.", L"Export", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    // Edited text is encoded as typed; %name tokens stay in the file for the game to expand.
+    arena2::TextDbWriteResult res;
+    std::wstring err;
+    if (!arena2::WriteTextDatabaseFile(m_text, path, &res, &err)) {
+        MessageBoxW(m_hwnd, err.c_str(), L"Export failed", MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    wchar_t buf[512]{};
+    swprintf_s(buf, L"Wrote %s (%zu records, %zu rebuilt from edits)", path.filename().wstring().c_str(), res.records, res.encodedRecords);
+    SetStatus(buf);
+}
+
 void MainWindow::CmdExportTes4QuestDialogue() {
     if (!m_questsLoaded) return;
 
@@ -4832,9 +5122,9 @@ void MainWindow::CmdExportTes4QuestDialogue() {
         for (size_t si = 0; si < rec->subrecords.size(); ++si) {
             auto& sr = rec->subrecords[si];
             auto& tok = sr.EnsureTokens();
-            if (!tok.plain.empty()) {
+            if (tok.plainLength) {
                 if (!out.empty()) out.append("\n");
-                out.append(tok.plain);
+                arena2::RenderPlain(tok, out);
             }
         }
         return Sanitize(out);
@@ -4950,21 +5240,254 @@ void MainWindow::OnLoadDone(LoadResult* r) {
 
     PopulateTree();
 
+    EnableMenuItem(hMenu, IDM_FILE_FIND_TEXT, MF_BYCOMMAND | MF_ENABLED);
     EnableMenuItem(hMenu, IDM_EXPORT_SUBRECORDS, MF_BYCOMMAND | MF_ENABLED);
     EnableMenuItem(hMenu, IDM_EXPORT_TOKENS, MF_BYCOMMAND | MF_ENABLED);
     EnableMenuItem(hMenu, IDM_EXPORT_VARIABLES, MF_BYCOMMAND | MF_ENABLED);
+    EnableMenuItem(hMenu, IDM_EXPORT_TEXT_DB, MF_BYCOMMAND | MF_ENABLED);
         EnableMenuItem(hMenu, IDM_EXPORT_QUESTS, MF_BYCOMMAND | (m_questsLoaded ? MF_ENABLED : MF_GRAYED));
         EnableMenuItem(hMenu, IDM_EXPORT_QUEST_STAGES, MF_BYCOMMAND | (m_questsLoaded ? MF_ENABLED : MF_GRAYED));
     DrawMenuBar(m_hwnd);
 
     wchar_t buf[512]{};
-    swprintf_s(buf, L"Loaded %zu records from %s (BSA archives: %zu)", m_text.records.size(), m_text.sourcePath.wstring().c_str(), m_bsaArchives.size());
+    swprintf_s(buf, L"Loaded %zu records from %s (BSA archives: %zu, %zu from index cache%s)", m_text.records.size(), m_text.sourcePath.wstring().c_str(), m_bsaArchives.size(), r->bsaFromSidecar,
+               m_quests.fromSnapshot ? L"; quests from snapshot" : L"");
     SetStatus(buf);
 
+    StartBsaMetaJob();
+    StartSearchIndexJob();
+    StartQrcPreloadJob();
+
     m_loading.store(false);
     delete r;
 }
 
+void MainWindow::StartBsaMetaJob() {
+    // Archives share their mapping when copied, so the job works on copies and never touches m_bsaArchives.
+    std::vector<battlespire::BsaArchive> pending;
+    for (const auto& a : m_bsaArchives) {
+        if (a.entryMeta.size() != a.entries.size()) pending.push_back(a);
+    }
+    if (pending.empty()) return;
+
+    std::thread([hwnd = m_hwnd, pending = std::move(pending)]() mutable {
+        auto* r = new BsaMetaResult();
+        for (auto& a : pending) {
+            a.ComputeEntryMeta();
+            std::wstring err;
+            battlespire::SaveBsaSidecar(CacheDir(), a, &err);
+            r->byCacheId.emplace_back(a.cacheId, std::move(a.entryMeta));
+        }
+        PostMessageW(hwnd, WM_APP_BSA_META_DONE, (WPARAM)r, 0);
+    }).detach();
+}
+
+void MainWindow::OnBsaMetaDone(BsaMetaResult* r) {
+    for (auto& [cacheId, meta] : r->byCacheId) {
+        for (auto& a : m_bsaArchives) {
+            if (a.cacheId == cacheId && meta.size() == a.entries.size()) a.entryMeta = std::move(meta);
+        }
+    }
+    delete r;
+}
+
+void MainWindow::StartSearchIndexJob() {
+    m_search.reset();
+    m_searchPending.clear();
+    m_searchPendingQuests.clear();
+    const uint32_t generation = ++m_searchGeneration;
+    if (m_findWnd.IsOpen()) m_findWnd.Refresh();
+
+    // The job re-parses copies of the raw bytes (no record tables or tokens) of TEXT.RSC and of any QRC already in
+    // memory (e.g. from a quest snapshot). The remaining QRCs are indexed as the preload job hands them over.
+    std::vector<std::pair<uint32_t, std::vector<uint8_t>>> sources;
+    sources.emplace_back(arena2::TextSearchIndex::kTextRsc, m_text.fileBytes);
+    if (m_questsLoaded) {
+        for (size_t i = 0; i < m_quests.quests.size(); ++i) {
+            if (m_quests.quests[i].qrcLoaded) sources.emplace_back(static_cast<uint32_t>(i + 1), m_quests.quests[i].qrc.fileBytes);
+        }
+    }
+
+    std::thread([hwnd = m_hwnd, generation, sources = std::move(sources)]() mutable {
+        auto* r = new SearchIndexResult();
+        r->generation = generation;
+        r->index = std::make_unique<arena2::TextSearchIndex>();
+        for (auto& [source, bytes] : sources) {
+            arena2::TextRsc db;
+            if (arena2::TextRsc::LoadFromBytes(std::move(bytes), {}, db, nullptr)) r->index->AddDatabase(source, db);
+        }
+        PostMessageW(hwnd, WM_APP_SEARCH_INDEX_DONE, (WPARAM)r, 0);
+    }).detach();
+}
+
+void MainWindow::MergeQuestSearch(arena2::TextSearchIndex&& built) {
+    if (!m_search) {
+        m_searchPendingQuests.push_back(std::move(built));
+        return;
+    }
+    m_search->Merge(std::move(built));
+}
+
+void MainWindow::OnSearchIndexDone(SearchIndexResult* r) {
+    if (r->generation == m_searchGeneration) {
+        m_search = std::move(r->index);
+        for (auto& built : m_searchPendingQuests) m_search->Merge(std::move(built));
+        m_searchPendingQuests.clear();
+        for (const auto& e : m_searchPending) m_search->SetText(e.source, e.recordId, e.subrecord, e.text);
+        m_searchPending.clear();
+        if (m_findWnd.IsOpen()) m_findWnd.Refresh();
+    }
+    delete r;
+}
+
+void MainWindow::StartQrcPreloadJob() {
+    const uint32_t generation = ++m_qrcPreloadGeneration;
+    if (!m_questsLoaded) return;
+
+    // The job gets each quest's QRC path and opcodes (all DeriveQuestDisplayName reads from the QBN); quests opened
+    // before it finishes keep the QRC they loaded themselves.
+    std::vector<size_t> indices;
+    std::vector<std::filesystem::path> paths;
+    std::vector<arena2::QuestQbn> qbns;
+    for (size_t i = 0; i < m_quests.quests.size(); ++i) {
+        const auto& q = m_quests.quests[i];
+        if (q.qrcLoaded) continue;
+        indices.push_back(i);
+        paths.push_back(q.qrcPath);
+        qbns.emplace_back().opcodes = q.qbn.opcodes;
+    }
+    if (indices.empty()) {
+        if (!m_quests.fromSnapshot) StartQuestSnapshotJob();
+        return;
+    }
+
+    std::thread([hwnd = m_hwnd, generation, indices = std::move(indices), paths = std::move(paths), qbns = std::move(qbns)]() {
+        // Finished quests are posted in small batches so tree labels fill in while the rest are still loading.
+        constexpr size_t kBatch = 32;
+        std::mutex mu;
+        auto batch = std::make_unique<QrcPreloadResult>();
+        batch->generation = generation;
+
+        auto post = [&](std::unique_ptr<QrcPreloadResult>& b, bool last) {
+            if (b->quests.empty() && !last) return;
+            b->last = last;
+            PostMessageW(hwnd, WM_APP_QRC_PRELOADED, (WPARAM)b.release(), 0);
+            b = std::make_unique<QrcPreloadResult>();
+            b->generation = generation;
+        };
+
+        winutil::ParallelFor(indices.size(), 0, [&](size_t i, size_t) {
+            std::error_code ec;
+            if (!std::filesystem::exists(paths[i], ec)) return;
+
+            QrcPreloadResult::Quest q;
+            q.index = indices[i];
+            if (!arena2::TextRsc::LoadFromFile(paths[i], q.qrc, nullptr)) return;
+            arena2::DeriveQuestDisplayName(qbns[i], q.qrc, q.displayName, q.displayNameSourceRecord);
+            q.search.AddDatabase(static_cast<uint32_t>(q.index + 1), q.qrc);
+
+            std::lock_guard<std::mutex> lock(mu);
+            batch->quests.push_back(std::move(q));
+            if (batch->quests.size() >= kBatch) post(batch, false);
+        });
+        post(batch, true);
+    }).detach();
+}
+
+void MainWindow::OnQrcPreloaded(QrcPreloadResult* r) {
+    if (r->generation == m_qrcPreloadGeneration) {
+        for (auto& q : r->quests) {
+            // A quest opened on demand meanwhile keeps its own QRC; edits made to it are already in the index, and
+            // the merge leaves indexed subrecords alone.
+            const bool adopted = m_quests.AdoptQrc(q.index, std::move(q.qrc), std::move(q.displayName), q.displayNameSourceRecord);
+            MergeQuestSearch(std::move(q.search));
+            if (!adopted) continue;
+
+            HTREEITEM h = q.index < m_questTreeItems.size() ? m_questTreeItems[q.index] : nullptr;
+            if (!h) continue;   // not inserted yet; TreeBuildTick labels it from the adopted name
+            std::wstring label = QuestTreeLabel(m_quests.quests[q.index]);
+            TVITEMW tv{};
+            tv.mask = TVIF_TEXT | TVIF_HANDLE;
+            tv.hItem = h;
+            tv.pszText = const_cast<wchar_t*>(label.c_str());
+            TreeView_SetItem(m_tree, &tv);
+        }
+        if (r->last && !m_quests.fromSnapshot) StartQuestSnapshotJob();
+    }
+    delete r;
+}
+
+void MainWindow::StartQuestSnapshotJob() {
+    // Written once every QRC and display name is in, so the next open of this folder needs no parsing. Only the
+    // serialized bytes go to the worker; stamping the files and writing happen there.
+    arena2::QuestSnapshotImage image;
+    std::wstring err;
+    if (!arena2::BuildQuestSnapshot(m_quests, image, &err)) return;
+    std::thread([image = std::move(image)]() {
+        std::wstring err;
+        arena2::WriteQuestSnapshot(CacheDir(), image, &err);
+    }).detach();
+}
+
+void MainWindow::UpdateSearchText(uint32_t source, uint16_t recordId, uint16_t subrecord, std::string_view text) {
+    if (m_search) {
+        m_search->SetText(source, recordId, subrecord, text);
+        if (m_findWnd.IsOpen()) m_findWnd.Refresh();
+    } else {
+        m_searchPending.push_back({ source, recordId, subrecord, std::string(text) });
+    }
+}
+
+std::wstring MainWindow::SearchSourceName(uint32_t source) const {
+    if (source == arena2::TextSearchIndex::kTextRsc) return L"TEXT.RSC";
+    const size_t qi = source - 1;
+    if (qi < m_quests.quests.size()) return winutil::WidenUtf8(m_quests.quests[qi].baseName) + L".QRC";
+    return L"Quest " + std::to_wstring(qi);
+}
+
+HTREEITEM MainWindow::FindTreeItem(HTREEITEM from, TreePayload::Kind kind, uint16_t recId, size_t questIdx) const {
+    for (HTREEITEM it = TreeView_GetChild(m_tree, from); it; it = TreeView_GetNextSibling(m_tree, it)) {
+        TVITEMW tv{};
+        tv.mask = TVIF_PARAM | TVIF_HANDLE;
+        tv.hItem = it;
+        TreeView_GetItem(m_tree, &tv);
+        const auto* p = reinterpret_cast<const TreePayload*>(tv.lParam);
+        if (p && p->kind == kind) {
+            if (kind == TreePayload::Kind::Quest ? p->questIndex == questIdx : p->textRecordId == recId) return it;
+        }
+        if (HTREEITEM found = FindTreeItem(it, kind, recId, questIdx)) return found;
+    }
+    return nullptr;
+}
+
+void MainWindow::RevealSearchHit(const arena2::TextSearchHit& hit) {
+    EndListPreviewEdit(true);
+
+    const bool quest = hit.source != arena2::TextSearchIndex::kTextRsc;
+    const size_t questIdx = quest ? hit.source - 1 : (size_t)-1;
+    HTREEITEM item = quest ? FindTreeItem(m_treeRootQuests, TreePayload::Kind::Quest, 0, questIdx)
+                           : FindTreeItem(m_treeRootText, TreePayload::Kind::TextRecord, hit.recordId, questIdx);
+    if (!item) {
+        SetStatus(L"That record is not in the Object Window yet.");
+        return;
+    }
+    TreeView_SelectItem(m_tree, item);
+    TreeView_EnsureVisible(m_tree, item);
+
+    int row = hit.subrecord;
+    if (quest) {
+        if (questIdx >= m_quests.quests.size()) return;
+        TabCtrl_SetCurSel(m_tabs, 2);
+        OnQuestTabChanged();
+        const size_t idx = m_quests.quests[questIdx].qrc.IndexOf(hit.recordId);
+        row = idx == SIZE_MAX ? -1 : (int)idx;
+    }
+    if (row < 0 || row >= ListView_GetItemCount(m_list)) return;
+    ListView_SetItemState(m_list, -1, 0, LVIS_SELECTED);
+    ListView_SetItemState(m_list, row, LVIS_SELECTED | LVIS_FOCUSED, LVIS_SELECTED | LVIS_FOCUSED);
+    ListView_EnsureVisible(m_list, row, FALSE);
+}
+
 static std::wstring Widen(const std::string& s) { return winutil::WidenUtf8(s); }
 static std::string Narrow(const std::wstring& s) { return winutil::NarrowUtf8(s); }
 
@@ -5083,56 +5606,17 @@ void MainWindow::InitIndicesModel() {
 }
 
 std::string MainWindow::ApplyOverrides(std::string_view in) const {
-    std::string out;
-    out.reserve(in.size());
-
-    auto isVarChar = [](unsigned char c) {
-        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
-    };
-
-    for (size_t i = 0; i < in.size(); ++i) {
-        unsigned char c = (unsigned char)in[i];
-
-        if (c == '%') {
-            size_t j = i + 1;
-            if (j < in.size() && isVarChar((unsigned char)in[j])) {
-                while (j < in.size() && isVarChar((unsigned char)in[j])) j++;
-                std::string tok(in.substr(i, j - i));
-                auto itImpl = m_varImplemented.find(tok);
-                if (itImpl != m_varImplemented.end() && itImpl->second) {
-                    auto it = m_varOverrides.find(tok);
-                    if (it != m_varOverrides.end() && !it->second.empty()) {
-                        out.append(it->second);
-                        i = j - 1;
-                        continue;
-                    }
-                }
-            }
-        }
-
-        if (c == '_') {
-            size_t j = i + 1;
-            if (j < in.size() && isVarChar((unsigned char)in[j])) {
-                while (j < in.size() && isVarChar((unsigned char)in[j])) j++;
-                if (j < in.size() && in[j] == '_') {
-                    std::string tok(in.substr(i, (j + 1) - i));
-                    auto itImpl = m_varImplemented.find(tok);
-                    if (itImpl != m_varImplemented.end() && itImpl->second) {
-                        auto it = m_varOverrides.find(tok);
-                        if (it != m_varOverrides.end() && !it->second.empty()) {
-                            out.append(it->second);
-                            i = j;
-                            continue;
-                        }
-                    }
-                }
-            }
-        }
+    return m_substituter.Apply(in);
+}
 
-        out.push_back((char)c);
+void MainWindow::RebuildSubstituter() {
+    std::vector<std::pair<std::string_view, std::string_view>> tokens;
+    tokens.reserve(m_varOverrides.size());
+    for (const auto& [tok, value] : m_varOverrides) {
+        auto it = m_varImplemented.find(tok);
+        if (it != m_varImplemented.end() && it->second) tokens.emplace_back(tok, value);
     }
-
-    return out;
+    m_substituter.Build(tokens);
 }
 
 void MainWindow::NoteDiscoveredVars(const arena2::TokenizedText& tt) {
@@ -5144,7 +5628,7 @@ void MainWindow::NoteDiscoveredVars(const arena2::TokenizedText& tt) {
     };
 
     for (const auto& v : tt.vars) {
-        const std::string tok = v.token;
+        const std::string tok(tt.TokenOf(v));
         if (!hasToken(tok)) {
             IndicesRow r{};
             r.token = tok;
@@ -5180,6 +5664,7 @@ void MainWindow::SetIndexOverrideByRow(int row, const std::wstring& value) {
 
     r.valueW = value;
     m_varOverrides[r.token] = Narrow(value);
+    RebuildSubstituter();
 
     RefreshPreviewIfVisible();
     SaveIndicesOverrides();
@@ -5226,6 +5711,7 @@ void MainWindow::LoadIndicesOverrides() {
         m_varOverrides[r.token] = Narrow(r.valueW);
         m_varImplemented[r.token] = r.implemented;
     }
+    RebuildSubstituter();
 }
 
 void MainWindow::SaveIndicesOverrides() {
@@ -5809,14 +6295,7 @@ static std::wstring ResolveSectionRecordPretty(const arena2::QuestEntry& q, uint
 
 static int SubRefIndexBest(const arena2::QbnSubRecord& s) {
     if (s.sectionId == 0) return -1;
-    int rec = (int)(s.localPtr & 0xFFu);
-    if (rec == 0xFF) {
-        if (s.value != 0xFFFFFFFFu && s.value != 0xFFFFFFFEu) {
-            rec = (int)(s.value & 0xFFFFu);
-        }
-    }
-    if (rec == 0xFF) return -1;
-    return rec;
+    return s.LinkedIndex();
 }
 
 static std::wstring FormatSubRefPretty(const arena2::QuestEntry& q, const arena2::QbnSubRecord& s) {
@@ -5885,39 +6364,20 @@ void MainWindow::PopulateQuestStages(size_t questIdx)
         return s;
     };
 
-    auto stateIdxFromSub = [&](const arena2::QbnSubRecord& sr) -> int {
-        if (sr.sectionId != 9)
-            return -1;
-        int idx = SubRefIndexBest(sr);
-        if (idx < 0)
-            return -1;
-        if ((size_t)idx >= nStates)
-            return -1;
-        return idx;
-    };
-
     std::vector<uint32_t> gateCount(nStates, 0);
     std::vector<uint32_t> targetCount(nStates, 0);
-    std::vector<uint32_t> anyCount(nStates, 0);
-    std::vector<std::vector<uint16_t>> logMsgs(nStates);
-
-	for (const auto& op : qbn.opcodes) {
-        int gate = stateIdxFromSub(op.sub[0]);
-        if (gate >= 0) {
-            gateCount[gate]++;
-            anyCount[gate]++;
-        }
+    std::vector<uint16_t> logMsg(nStates, 0);
 
-        for (int i = 1; i < 5; i++) {
-            int t = stateIdxFromSub(op.sub[i]);
-            if (t >= 0) {
-                targetCount[t]++;
-                anyCount[t]++;
+    for (size_t s = 0; s < nStates && s <= 0xFFFF; s++) {
+        for (const auto& ref : qbn.xref.Find(arena2::QbnRefKind::State, (uint16_t)s)) {
+            if (ref.slot != 0) {
+                targetCount[s]++;
+                continue;
             }
-        }
-
-        if (op.opCode == 0x0017u && gate >= 0 && op.messageId != 0x0000u && op.messageId != 0xFFFFu) {
-            logMsgs[gate].push_back(op.messageId);
+            gateCount[s]++;
+            const auto& op = qbn.opcodes[ref.opcode];
+            if (!logMsg[s] && op.opCode == 0x0017u && op.messageId != 0x0000u && op.messageId != 0xFFFFu)
+                logMsg[s] = op.messageId;
         }
     }
 
@@ -5931,9 +6391,7 @@ void MainWindow::PopulateQuestStages(size_t questIdx)
         if (rec->subrecords.empty())
             return L"";
         arena2::TextSubrecord& sr = rec->subrecords[0];
-        arena2::TokenizedText& tt = sr.EnsureTokens();
-        const std::string& base = sr.hasUserOverride ? sr.userOverride : tt.plain;
-        std::string txt = ApplyOverrides(base);
+        std::string txt = ApplyOverrides(sr.EffectivePlain());
         return trimOneLineW(winutil::WidenUtf8(txt), 120);
     };
 
@@ -5945,8 +6403,8 @@ void MainWindow::PopulateQuestStages(size_t questIdx)
         std::wstring colStage = std::to_wstring(stageNum);
 
         std::wstring colLog;
-        if (!logMsgs[s].empty())
-            colLog = qrcPlain(logMsgs[s][0]);
+        if (logMsg[s])
+            colLog = qrcPlain(logMsg[s]);
 
         std::wstring colScript = L"G:" + std::to_wstring(gateCount[s]) + L" T:" + std::to_wstring(targetCount[s]);
 
@@ -6043,17 +6501,11 @@ void MainWindow::ShowQuestStagePreview(size_t questIdx, int listIndex)
         if (rec->subrecords.empty())
             return L"";
         arena2::TextSubrecord& sr = rec->subrecords[0];
-        arena2::TokenizedText& tt = sr.EnsureTokens();
-        const std::string& base = sr.hasUserOverride ? sr.userOverride : tt.plain;
-        std::string txt = ApplyOverrides(base);
+        std::string txt = ApplyOverrides(sr.EffectivePlain());
         return trimOneLineW(winutil::WidenUtf8(txt), 160);
     };
 
-    auto stateIdxFromSub = [&](const arena2::QbnSubRecord& sr) -> int {
-        if (sr.sectionId != 9)
-            return -1;
-        return SubRefIndexBest(sr);
-    };
+    const auto stageRefs = q.qbn.xref.Find(arena2::QbnRefKind::State, (uint16_t)stateIdx);
 
     std::wstring varName;
 	varName = VarFromFirstName(st.varNames);
@@ -6081,13 +6533,11 @@ void MainWindow::ShowQuestStagePreview(size_t questIdx, int listIndex)
     std::vector<uint16_t> logIds;
     logIds.reserve(8);
 
-	for (const auto& op : q.qbn.opcodes) {
-        if (op.opCode != 0x0017u)
+    for (const auto& ref : stageRefs) {
+        if (ref.slot != 0)
             continue;
-        if (op.messageId == 0x0000u || op.messageId == 0xFFFFu)
-            continue;
-        int gate = stateIdxFromSub(op.sub[0]);
-        if (gate == stateIdx)
+        const auto& op = q.qbn.opcodes[ref.opcode];
+        if (op.opCode == 0x0017u && op.messageId != 0x0000u && op.messageId != 0xFFFFu)
             logIds.push_back(op.messageId);
     }
 
@@ -6111,21 +6561,12 @@ void MainWindow::ShowQuestStagePreview(size_t questIdx, int listIndex)
     int shown = 0;
     const int kMaxShown = 250;
 
-	for (const auto& op : q.qbn.opcodes) {
-        int gate = stateIdxFromSub(op.sub[0]);
-        bool isGate = (gate == stateIdx);
-
-        bool isTarget = false;
-        for (int i = 1; i < 5; i++) {
-            int t = stateIdxFromSub(op.sub[i]);
-            if (t == stateIdx) {
-                isTarget = true;
-                break;
-            }
-        }
-
-        if (!isGate && !isTarget)
+    // The index lists each op-code once per referencing slot, gate (slot 0) first.
+    for (size_t r = 0; r < stageRefs.size(); r++) {
+        if (r > 0 && stageRefs[r].opcode == stageRefs[r - 1].opcode)
             continue;
+        const auto& op = q.qbn.opcodes[stageRefs[r].opcode];
+        const bool isGate = (stageRefs[r].slot == 0);
 
         if (shown++ >= kMaxShown) {
             out += L"  ... truncated ...\r\n";
@@ -6196,9 +6637,7 @@ void MainWindow::PopulateQuestText(size_t questIdx)
         std::wstring preview;
         if (!rec.subrecords.empty()) {
             auto& sr0 = rec.subrecords[0];
-            auto& tt = sr0.EnsureTokens();
-            const std::string& base = sr0.hasUserOverride ? sr0.userOverride : tt.plain;
-            std::string applied = ApplyOverrides(base);
+            std::string applied = ApplyOverrides(sr0.EffectivePlain());
             preview = trimOneLine(winutil::WidenUtf8(applied), 96);
         }
 
@@ -6238,9 +6677,7 @@ void MainWindow::ShowQuestTextPreview(size_t questIdx, int recRow) {
 
     for (size_t i = 0; i < r.subrecords.size(); ++i) {
         auto& sr = r.subrecords[i];
-        auto& tt = sr.EnsureTokens();
-        const std::string& base = sr.hasUserOverride ? sr.userOverride : tt.plain;
-        std::wstring line = winutil::WidenUtf8(ApplyOverrides(base));
+        std::wstring line = winutil::WidenUtf8(ApplyOverrides(sr.EffectivePlain()));
         msg += L"[" + std::to_wstring(i) + L"] " + line + L"\r\n";
     }
 
@@ -6348,6 +6785,21 @@ LRESULT CALLBACK MainWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM
     case WM_APP_LOAD_DONE:
         self->OnLoadDone(reinterpret_cast<LoadResult*>(wParam));
         return 0;
+    case WM_APP_EXTRACT_PROGRESS:
+        self->OnExtractProgress((size_t)wParam, (size_t)lParam);
+        return 0;
+    case WM_APP_EXTRACT_DONE:
+        self->OnExtractDone(reinterpret_cast<battlespire::BsaExtractResult*>(wParam));
+        return 0;
+    case WM_APP_BSA_META_DONE:
+        self->OnBsaMetaDone(reinterpret_cast<BsaMetaResult*>(wParam));
+        return 0;
+    case WM_APP_SEARCH_INDEX_DONE:
+        self->OnSearchIndexDone(reinterpret_cast<SearchIndexResult*>(wParam));
+        return 0;
+    case WM_APP_QRC_PRELOADED:
+        self->OnQrcPreloaded(reinterpret_cast<QrcPreloadResult*>(wParam));
+        return 0;
     case WM_COMMAND:
         self->OnCommand(LOWORD(wParam));
         return 0;
@@ -4,13 +4,24 @@
 #include "../arena2/TextRscIndex.h"
 #include "../arena2/VarHashCatalog.h"
 #include "../arena2/QuestCatalog.h"
+#include "../arena2/TextSearch.h"
+#include "../arena2/TokenSubstituter.h"
 #include "../battlespire/BattlespireFormats.h"
+#include "../battlespire/BsaExtract.h"
+#include "../battlespire/BsaSidecar.h"
+#include "../battlespire/AssetVfs.h"
 #include "Splitter.h"
 #include "IndicesPrefsWindow.h"
+#include "FindTextWindow.h"
 
 namespace ui {
 
 constexpr UINT WM_APP_LOAD_DONE = WM_APP + 1;
+constexpr UINT WM_APP_EXTRACT_PROGRESS = WM_APP + 2;   // wParam = entries done, lParam = total
+constexpr UINT WM_APP_EXTRACT_DONE = WM_APP + 3;       // wParam = BsaExtractResult*
+constexpr UINT WM_APP_BSA_META_DONE = WM_APP + 4;      // wParam = BsaMetaResult*
+constexpr UINT WM_APP_SEARCH_INDEX_DONE = WM_APP + 5;  // wParam = SearchIndexResult*
+constexpr UINT WM_APP_QRC_PRELOADED = WM_APP + 6;      // wParam = QrcPreloadResult*
 constexpr UINT_PTR TIMER_POP_TREE = 1;
 
 class MainWindow {
@@ -36,6 +47,11 @@ public:
     const std::vector<IndicesRow>& GetIndicesRows() const { return m_indicesRows; }
     void SetIndexOverrideByRow(int row, const std::wstring& value);
 
+    // Full-text search over TEXT.RSC and the quest QRCs; null until the background build finishes.
+    const arena2::TextSearchIndex* TextSearch() const { return m_search.get(); }
+    std::wstring SearchSourceName(uint32_t source) const;
+    void RevealSearchHit(const arena2::TextSearchHit& hit);
+
     bool Create(HINSTANCE hInst);
     HWND Hwnd() const { return m_hwnd; }
 
@@ -65,6 +81,22 @@ private:
     struct LoadResult;
     void OnLoadDone(LoadResult* r);
 
+    struct BsaMetaResult;
+    void StartBsaMetaJob();
+    void OnBsaMetaDone(BsaMetaResult* r);
+
+    struct SearchIndexResult;
+    void StartSearchIndexJob();
+    void OnSearchIndexDone(SearchIndexResult* r);
+    void MergeQuestSearch(arena2::TextSearchIndex&& built);
+    void UpdateSearchText(uint32_t source, uint16_t recordId, uint16_t subrecord, std::string_view text);
+    HTREEITEM FindTreeItem(HTREEITEM from, TreePayload::Kind kind, uint16_t recId, size_t questIdx) const;
+
+    struct QrcPreloadResult;
+    void StartQrcPreloadJob();
+    void OnQrcPreloaded(QrcPreloadResult* r);
+    void StartQuestSnapshotJob();
+
     HWND m_hwnd{};
     HWND m_tree{};
     HWND m_list{};
@@ -79,6 +111,7 @@ private:
     int m_inplaceItem{ -1 };
     int m_inplaceSubItem{ -1 };
     bool m_inplaceEnding{ false };
+    std::wstring m_inplaceOriginal;   // full rich text the editor was seeded with, '\n' line breaks
 
 
     Splitter m_splitLR{};
@@ -96,6 +129,7 @@ private:
     // Quests
     arena2::QuestCatalog m_quests;
     bool m_questsLoaded{ false };
+    uint32_t m_qrcPreloadGeneration{};
 
     // Battlespire BSA archives
     std::vector<battlespire::BsaArchive> m_bsaArchives;
@@ -103,6 +137,24 @@ private:
 
     std::atomic_bool m_loading{ false };
 
+    // Text search index, built in the background after each load. Edits made while it builds are replayed on arrival.
+    struct PendingSearchEdit {
+        uint32_t source{};
+        uint16_t recordId{};
+        uint16_t subrecord{};
+        std::string text;
+    };
+    std::unique_ptr<arena2::TextSearchIndex> m_search;
+    std::vector<PendingSearchEdit> m_searchPending;
+    std::vector<arena2::TextSearchIndex> m_searchPendingQuests;   // QRCs indexed by the preload before the index arrived
+    uint32_t m_searchGeneration{};
+    FindTextWindow m_findWnd;
+
+    // Background BSA extraction
+    std::atomic_bool m_extracting{ false };
+    std::atomic_bool m_extractCancel{ false };
+    std::wstring m_extractLabel;
+
     // Tree model (payload-backed)
     HTREEITEM m_treeRootText{};
     HTREEITEM m_treeRootQuests{};
@@ -121,6 +173,7 @@ private:
     std::vector<size_t> m_pendingQuestIdx;
     std::vector<HTREEITEM> m_pendingQuestParents;
     size_t m_questInsertPos{ 0 };
+    std::vector<HTREEITEM> m_questTreeItems;   // by quest index, so preloaded names can relabel inserted items
 
     // BSA dialogue viewer state
     BsaDialogueKind m_bsaDialogueKind{ BsaDialogueKind::None };
@@ -136,11 +189,13 @@ private:
     std::unordered_map<std::string, bool> m_varImplemented;        // token -> implemented
     std::vector<IndicesRow> m_indicesRows;
     IndicesPrefsWindow m_indicesWnd;
+    arena2::TokenSubstituter m_substituter;                        // compiled from the two maps above
 
     void InitIndicesModel();
     void LoadIndicesOverrides();
     void SaveIndicesOverrides();
     std::string ApplyOverrides(std::string_view in) const;
+    void RebuildSubstituter();   // after any override value or implemented flag changes
     void RefreshPreviewIfVisible();
     void NoteDiscoveredVars(const arena2::TokenizedText& tt);
 
@@ -163,6 +218,7 @@ private:
     void BeginListPreviewEdit(int item, int subItem);
     void EndListPreviewEdit(bool commit);
     void CommitListPreviewEdit(int item, int subItem, const std::wstring& newText);
+    std::wstring ListPreviewRichText(int item);
     static LRESULT CALLBACK InplaceEditProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 
@@ -193,12 +249,16 @@ private:
     void CmdOpenArena2();
     void CmdOpenSpire();
     void CmdExtractBsa();
+    void OnExtractProgress(size_t done, size_t total);
+    void OnExtractDone(battlespire::BsaExtractResult* r);
     void CmdExportSubrecords();
     void CmdExportTokens();
     void CmdExportVariables();
     void CmdExportQuests();
     void CmdExportQuestStages();
     void CmdExportTes4QuestDialogue();
+    void CmdExportTextDatabase();
+    void CmdShowDiagnostics();
 
     void SetStatus(const std::wstring& s);
     void SendLevelToPreview(const battlespire::Bs6Scene* scene, const std::wstring& label);
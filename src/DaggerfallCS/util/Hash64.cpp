@@ -0,0 +1,90 @@
+#include "pch.h"
+#include "Hash64.h"
+
+namespace winutil {
+
+static constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t kPrime3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+static constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+static uint64_t Rotl(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+
+static uint64_t Load64(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t Load32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint64_t Round(uint64_t acc, uint64_t input) {
+    acc += input * kPrime2;
+    acc = Rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+static uint64_t MergeRound(uint64_t acc, uint64_t val) {
+    acc ^= Round(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+uint64_t Hash64(const void* data, size_t size, uint64_t seed) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const uint8_t* end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        const uint8_t* limit = end - 32;
+        do {
+            v1 = Round(v1, Load64(p)); p += 8;
+            v2 = Round(v2, Load64(p)); p += 8;
+            v3 = Round(v3, Load64(p)); p += 8;
+            v4 = Round(v4, Load64(p)); p += 8;
+        } while (p <= limit);
+
+        h = Rotl(v1, 1) + Rotl(v2, 7) + Rotl(v3, 12) + Rotl(v4, 18);
+        h = MergeRound(h, v1);
+        h = MergeRound(h, v2);
+        h = MergeRound(h, v3);
+        h = MergeRound(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+
+    h += static_cast<uint64_t>(size);
+
+    while (p + 8 <= end) {
+        h ^= Round(0, Load64(p));
+        h = Rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= uint64_t(Load32(p)) * kPrime1;
+        h = Rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= uint64_t(*p) * kPrime5;
+        h = Rotl(h, 11) * kPrime1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "../pch.h"
+
+namespace winutil {
+
+// 64-bit non-cryptographic content hash (XXH64). Stable across runs, so it can be persisted.
+uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t Hash64(std::string_view s, uint64_t seed = 0) { return Hash64(s.data(), s.size(), seed); }
+
+}
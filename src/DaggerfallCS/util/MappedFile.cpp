@@ -0,0 +1,50 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+namespace winutil {
+
+MappedFile::~MappedFile() {
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+}
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::filesystem::path& path, std::wstring* err) {
+    auto mf = std::make_shared<MappedFile>();
+
+    mf->m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mf->m_file == INVALID_HANDLE_VALUE) {
+        if (err) *err = L"Failed to open file.";
+        return nullptr;
+    }
+
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(mf->m_file, &sz) || sz.QuadPart < 0) {
+        if (err) *err = L"Failed to read file size.";
+        return nullptr;
+    }
+    if (uint64_t(sz.QuadPart) > uint64_t(SIZE_MAX)) {
+        if (err) *err = L"File is too large to map.";
+        return nullptr;
+    }
+
+    // Zero-length files cannot be mapped; an empty view is still a valid result.
+    if (sz.QuadPart == 0) return mf;
+
+    mf->m_mapping = CreateFileMappingW(mf->m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mf->m_mapping) {
+        if (err) *err = L"Failed to create file mapping.";
+        return nullptr;
+    }
+
+    mf->m_data = static_cast<const uint8_t*>(MapViewOfFile(mf->m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mf->m_data) {
+        if (err) *err = L"Failed to map file view.";
+        return nullptr;
+    }
+    mf->m_size = static_cast<size_t>(sz.QuadPart);
+    return mf;
+}
+
+}
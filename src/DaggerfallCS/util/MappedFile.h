@@ -0,0 +1,31 @@
+#pragma once
+#include "../pch.h"
+#include <memory>
+#include <span>
+
+namespace winutil {
+
+// Read-only view of a whole file. Uses a Win32 file mapping so large archives are paged in on demand
+// instead of being copied into memory up front. Shared between copies of the owning object.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    static std::shared_ptr<const MappedFile> Open(const std::filesystem::path& path, std::wstring* err);
+
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    std::span<const uint8_t> Bytes() const { return { m_data, m_size }; }
+
+private:
+    HANDLE m_file{ INVALID_HANDLE_VALUE };
+    HANDLE m_mapping{ nullptr };
+    const uint8_t* m_data{ nullptr };
+    size_t m_size{};
+};
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "../pch.h"
+
+namespace winutil {
+
+// 32-bit FNV-1a, for in-memory hash tables keyed by short names (archive entries, text variables).
+inline constexpr uint32_t kFnv1aBasis = 2166136261u;
+inline constexpr uint32_t kFnv1aPrime = 16777619u;
+
+inline uint32_t Fnv1aStep(uint32_t h, uint8_t b) {
+    return (h ^ b) * kFnv1aPrime;
+}
+
+// Archive and asset names compare case-insensitively (ASCII upper-case folding).
+inline uint8_t FoldUpper(char c) {
+    return static_cast<uint8_t>(toupper(static_cast<unsigned char>(c)));
+}
+
+// FNV-1a over the upper-cased bytes; pass the previous result as h to hash a name given in pieces.
+inline uint32_t HashFolded(std::string_view s, uint32_t h = kFnv1aBasis) {
+    for (char c : s) h = Fnv1aStep(h, FoldUpper(c));
+    return h;
+}
+
+inline bool EqualsFolded(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (FoldUpper(a[i]) != FoldUpper(b[i])) return false;
+    }
+    return true;
+}
+
+// Name up to its first dot.
+inline std::string_view NameStem(std::string_view name) {
+    const size_t dot = name.find('.');
+    return dot == std::string_view::npos ? name : name.substr(0, dot);
+}
+
+}
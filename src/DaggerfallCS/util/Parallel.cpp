@@ -0,0 +1,28 @@
+#include "pch.h"
+#include "Parallel.h"
+
+namespace winutil {
+
+size_t DefaultWorkerCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? (size_t)n : 1;
+}
+
+void ParallelFor(size_t count, size_t workers, const std::function<void(size_t index, size_t worker)>& fn) {
+    if (count == 0) return;
+    if (workers == 0) workers = DefaultWorkerCount();
+    workers = std::min(workers, count);
+
+    std::atomic<size_t> next{ 0 };
+    auto run = [&](size_t worker) {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) fn(i, worker);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (size_t w = 1; w < workers; ++w) threads.emplace_back(run, w);
+    run(0);
+    for (auto& t : threads) t.join();
+}
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "../pch.h"
+#include <functional>
+
+namespace winutil {
+
+// Number of workers to use when the caller does not specify one (hardware threads, at least 1).
+size_t DefaultWorkerCount();
+
+// Runs fn(index, worker) for every index in [0, count) on up to `workers` threads (0 = default).
+// Indices are handed out dynamically so uneven work balances itself; the calling thread takes part
+// and the call returns once every index has been processed.
+void ParallelFor(size_t count, size_t workers, const std::function<void(size_t index, size_t worker)>& fn);
+
+}